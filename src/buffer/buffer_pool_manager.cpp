@@ -1,3 +1,10 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
 #include "buffer/buffer_pool_manager.h"
 
 namespace cmudb {
@@ -5,39 +12,93 @@ namespace cmudb {
     /*
      * BufferPoolManager Constructor
      * When log_manager is nullptr, logging is disabled (for test purpose)
-     * WARNING: Do Not Edit This Function
+     * num_instances: number of independent instances the pool is split into,
+     * frames are distributed as evenly as possible among them
+     * replacer_type: replacement policy used by every instance
      */
     BufferPoolManager::BufferPoolManager(size_t pool_size,
                                          DiskManager *disk_manager,
-                                         LogManager *log_manager)
-            : pool_size_(pool_size), disk_manager_(disk_manager),
-              log_manager_(log_manager) {
-        // a consecutive memory space for buffer pool
+                                         LogManager *log_manager,
+                                         size_t num_instances,
+                                         ReplacerType replacer_type)
+            : pool_size_(pool_size), num_instances_(num_instances),
+              disk_manager_(disk_manager), log_manager_(log_manager),
+              flush_thread_(nullptr), flush_running_(false), clean_ratio_(0),
+              prefetch_thread_(nullptr), prefetch_running_(false),
+              prefetch_busy_(false) {
+        assert(num_instances_ > 0 && num_instances_ <= pool_size_);
+        // a consecutive memory space for buffer pool, aligned for direct I/O
+        assert(PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0);
+        void *frames;
+        if (posix_memalign(&frames, DIRECT_IO_ALIGNMENT, pool_size_ * PAGE_SIZE) != 0) {
+            throw std::bad_alloc();
+        }
+        frames_ = static_cast<char *>(frames);
         pages_ = new Page[pool_size_];
-        page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
-        replacer_ = new LRUReplacer<Page *>;
-        free_list_ = new std::list<Page *>;
-
-        // put all the pages into free list
         for (size_t i = 0; i < pool_size_; ++i) {
-            free_list_->push_back(&pages_[i]);
+            pages_[i].data_ = frames_ + i * PAGE_SIZE;
+            pages_[i].ResetMemory();
+        }
+        instances_ = new Instance[num_instances_];
+
+        size_t offset = 0;
+        for (size_t i = 0; i < num_instances_; ++i) {
+            Instance &instance = instances_[i];
+            instance.pages_ = pages_ + offset;
+            instance.pool_size_ = pool_size_ / num_instances_ +
+                                  (i < pool_size_ % num_instances_ ? 1 : 0);
+            instance.page_table_ = new PageTable(instance.pool_size_);
+            switch (replacer_type) {
+                case ReplacerType::CLOCK:
+                    instance.replacer_ = new ClockReplacer(instance.pages_, instance.pool_size_);
+                    break;
+                case ReplacerType::LRU_K:
+                    instance.replacer_ = new LRUKReplacer<Page *>;
+                    break;
+                default:
+                    instance.replacer_ = new LRUReplacer<Page *>;
+                    break;
+            }
+            instance.free_list_ = new std::list<Page *>;
+            instance.unpin_clock_ = 0;
+            instance.unpin_time_.assign(instance.pool_size_, 0);
+
+            // put all the pages of this instance into its free list
+            for (size_t j = 0; j < instance.pool_size_; ++j) {
+                instance.free_list_->push_back(&instance.pages_[j]);
+            }
+            offset += instance.pool_size_;
         }
     }
 
     /*
      * BufferPoolManager Deconstructor
-     * WARNING: Do Not Edit This Function
      */
     BufferPoolManager::~BufferPoolManager() {
+        StopFlushThread();
+        if (prefetch_thread_) {
+            {
+                std::lock_guard<std::mutex> guard(prefetch_latch_);
+                prefetch_running_ = false;
+            }
+            prefetch_cv_.notify_one();
+            prefetch_thread_->join();
+            delete prefetch_thread_;
+        }
+        for (size_t i = 0; i < num_instances_; ++i) {
+            delete instances_[i].page_table_;
+            delete instances_[i].replacer_;
+            delete instances_[i].free_list_;
+        }
+        delete[] instances_;
         delete[] pages_;
-        delete page_table_;
-        delete replacer_;
-        delete free_list_;
+        free(frames_);
     }
 
     /**
      * 1. search hash table.
-     *  1.1 if exist, pin the page and return immediately
+     *  1.1 if exist, pin the page, wait until its pending read (if any) is
+     *      done and return
      *  1.2 if no exist, find a replacement entry from either free list or lru
      *      replacer. (NOTE: always find from free list first)
      * 2. If the entry chosen for replacement is dirty, write it back to disk.
@@ -45,33 +106,57 @@ namespace cmudb {
      * entry for the new page.
      * 4. Update page metadata, read page content from disk file and return page
      * pointer
+     * Disk I/O of step 2 and 4 is done with the instance latch released; the
+     * frame is registered under page_id and marked as under I/O meanwhile, so
+     * concurrent fetchers of the same page wait for it instead of reading it
+     * again.
+     * A page failing its checksum is not buffered, and nullptr is returned to
+     * every fetcher waiting for it.
      */
     Page *BufferPoolManager::FetchPage(page_id_t page_id) {
         if (page_id == INVALID_PAGE_ID) {
             return nullptr;
         }
-        latch_.lock();
+        Instance &instance = GetInstance(page_id);
+        std::unique_lock<std::mutex> lock(instance.latch_);
         Page *page;
-        bool inHashList = page_table_->Find(page_id, page);
-        if (inHashList) {
-            if (page->pin_count_ == 0) {
-                replacer_->Erase(page);
-            }
-            ++page->pin_count_;
-            latch_.unlock();
-            return page;
-        } else {
-            page = GetPage();
+        while (true) {
+            bool inHashList = instance.page_table_->Find(page_id, page);
+            if (inHashList) {
+                if (page->pin_count_ == 0) {
+                    instance.replacer_->Erase(page);
+                }
+                ++page->pin_count_;
+                instance.io_cv_.wait(lock, [page] { return !page->is_io_; });
+                // the read of the page failed, give up our pin
+                if (page->page_id_ != page_id) {
+                    DiscardPage(instance, page);
+                    return nullptr;
+                }
+                return page;
+            }
+            // an evicted dirty copy of this page may still be on its way to disk
+            if (instance.writing_.count(page_id) == 0) {
+                break;
+            }
+            instance.io_cv_.wait(lock);
         }
+        page = GetPage(instance, page_id, lock);
         if (page) {
-            page->ResetPage();
-            disk_manager_->ReadPage(page_id, page->data_);
-            page->page_id_ = page_id;
-            page->is_dirty_ = false;
-            page_table_->Insert(page->page_id_, page);
-            ++page->pin_count_;
+            lock.unlock();
+            bool valid = true;
+            if (!MapPage(page)) {
+                page->ResetMemory();
+                valid = disk_manager_->ReadPage(page_id, page->data_);
+            }
+            lock.lock();
+            page->is_io_ = false;
+            instance.io_cv_.notify_all();
+            if (!valid) {
+                DiscardPage(instance, page);
+                return nullptr;
+            }
         }
-        latch_.unlock();
         return page;
     }
 
@@ -82,10 +167,14 @@ namespace cmudb {
      * dirty flag of this page
      */
     bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
-        latch_.lock();
+        if (page_id == INVALID_PAGE_ID) {
+            return false;
+        }
+        Instance &instance = GetInstance(page_id);
+        instance.latch_.lock();
         Page *page;
-        if (page_id == INVALID_PAGE_ID || !page_table_->Find(page_id, page) || page->pin_count_ < 1) {
-            latch_.unlock();
+        if (!instance.page_table_->Find(page_id, page) || page->pin_count_ < 1) {
+            instance.latch_.unlock();
             return false;
         }
         if (page->is_dirty_ && !is_dirty) {
@@ -94,9 +183,10 @@ namespace cmudb {
         page->is_dirty_ = is_dirty;
         --page->pin_count_;
         if (page->pin_count_ == 0) {
-            replacer_->Insert(page);
+            instance.replacer_->Insert(page);
+            instance.unpin_time_[page - instance.pages_] = ++instance.unpin_clock_;
         }
-        latch_.unlock();
+        instance.latch_.unlock();
         return true;
     }
 
@@ -107,19 +197,70 @@ namespace cmudb {
      * NOTE: make sure page_id != INVALID_PAGE_ID
      */
     bool BufferPoolManager::FlushPage(page_id_t page_id) {
-        latch_.lock();
+        if (page_id == INVALID_PAGE_ID) {
+            return false;
+        }
+        Instance &instance = GetInstance(page_id);
+        std::unique_lock<std::mutex> lock(instance.latch_);
+        // a previous copy must reach disk first, writes of a page never overlap
+        instance.io_cv_.wait(lock, [&instance, page_id] {
+            return instance.writing_.count(page_id) == 0;
+        });
         Page *page;
-        if (page_id == INVALID_PAGE_ID || !page_table_->Find(page_id, page)) {
-            latch_.unlock();
+        if (!instance.page_table_->Find(page_id, page)) {
             return false;
         }
+        if (page->is_io_) {
+            // page content is not valid yet, it is clean once the read is done
+            return true;
+        }
 
-        disk_manager_->WritePage(page_id, page->data_);
-        page->is_dirty_ = false;
-        latch_.unlock();
+        std::vector<WriteBack> batch;
+        StartWriteBack(instance, page, batch);
+        lock.unlock();
+        FinishWriteBack(batch);
         return true;
     }
 
+    /*
+     * Checkpoint the buffer pool: write every dirty page to disk. Dirty frames
+     * are copied out instance by instance, then written in page id order with
+     * no latch held, and synced once at the end. When this returns every page
+     * that was dirty at the time of the call, or was already being written
+     * back, is durable on disk.
+     * @param bytes_written: if not null, set to the number of bytes written
+     * @return: number of pages written
+     */
+    size_t BufferPoolManager::FlushAllPages(size_t *bytes_written) {
+        std::vector<WriteBack> batch;
+        for (size_t i = 0; i < num_instances_; ++i) {
+            Instance &instance = instances_[i];
+            std::unique_lock<std::mutex> lock(instance.latch_);
+            // wait for writes started before the checkpoint
+            instance.io_cv_.wait(lock, [&instance] {
+                return instance.writing_.empty();
+            });
+            for (size_t j = 0; j < instance.pool_size_; ++j) {
+                Page *page = &instance.pages_[j];
+                if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_ &&
+                    !page->is_io_) {
+                    StartWriteBack(instance, page, batch);
+                }
+            }
+        }
+        // compressed pages take less than PAGE_SIZE on disk
+        int64_t start_bytes = disk_manager_->GetNumBytesWritten();
+        size_t num_pages = FinishWriteBack(batch);
+        if (bytes_written != nullptr) {
+            *bytes_written = static_cast<size_t>(
+                disk_manager_->GetNumBytesWritten() - start_bytes);
+        }
+        if (num_pages > 0) {
+            disk_manager_->Sync();
+        }
+        return num_pages;
+    }
+
     /**
      * User should call this method for deleting a page. This routine will call
      * disk manager to deallocate the page. First, if page is found within page
@@ -127,25 +268,35 @@ namespace cmudb {
      * of page table, reseting page metadata and adding back to free list. Second,
      * call disk manager's DeallocatePage() method to delete from disk file. If
      * the page is found within page table, but pin_count != 0, return false
+     * The page id may be handed out again right away, so a write back of the
+     * page still in flight is waited for first, and so is a read ahead of it.
      */
     bool BufferPoolManager::DeletePage(page_id_t page_id) {
-        latch_.lock();
-        Page *page;
-        if (page_id == INVALID_PAGE_ID || !page_table_->Find(page_id, page)) {
-            latch_.unlock();
+        if (page_id == INVALID_PAGE_ID) {
             return true;
         }
-        if (page->pin_count_ > 0) {
-            latch_.unlock();
+        if (disk_manager_->IsReadOnly()) {
             return false;
         }
-
-        page_table_->Remove(page_id);
-        replacer_->Erase(page);
+        Instance &instance = GetInstance(page_id);
+        std::unique_lock<std::mutex> lock(instance.latch_);
+        Page *page;
+        bool buffered = false;
+        instance.io_cv_.wait(lock, [&instance, page_id, &page, &buffered] {
+            buffered = instance.page_table_->Find(page_id, page);
+            return instance.writing_.count(page_id) == 0 &&
+                   (!buffered || !page->is_io_);
+        });
+        if (buffered) {
+            if (page->pin_count_ > 0) {
+                return false;
+            }
+            instance.page_table_->Remove(page_id);
+            instance.replacer_->Forget(page);
+            page->ResetPage();
+            instance.free_list_->push_back(page);
+        }
         disk_manager_->DeallocatePage(page_id);
-        page->ResetPage();
-        free_list_->push_back(page);
-        latch_.unlock();
         return true;
     }
 
@@ -156,37 +307,384 @@ namespace cmudb {
      * from free list or lru replacer(NOTE: always choose from free list first),
      * update new page's metadata, zero out memory and add corresponding entry
      * into page table. return nullptr if all the pages in pool are pinned
+     * Since the instance is decided by the page id, the page is allocated first
+     * and given back to disk manager if its instance has no frame left.
      */
     Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-        latch_.lock();
-        Page *page = GetPage();
-        if (page) {
-            page->ResetPage();
-            page_id = disk_manager_->AllocatePage();
-            page->page_id_ = page_id;
-            disk_manager_->ReadPage(page->page_id_, page->data_);
-            ++page->pin_count_;
-            page_table_->Insert(page->page_id_, page);
+        return InitNewPage(disk_manager_->AllocatePage(), page_id);
+    }
+
+    /*
+     * Same as NewPage, for objects read in page order: the page is allocated
+     * in the extent of near (or a new extent if near is INVALID_PAGE_ID), see
+     * DiskManager::AllocateExtentPage
+     */
+    Page *BufferPoolManager::NewExtentPage(page_id_t &page_id, page_id_t near) {
+        return InitNewPage(disk_manager_->AllocateExtentPage(near), page_id);
+    }
+
+    /*
+     * Put freshly allocated new_page_id into a zeroed frame, give the page id
+     * back to disk manager if there is no frame for it. A stale copy of the
+     * page read ahead while it was free is reused as the frame
+     */
+    Page *BufferPoolManager::InitNewPage(page_id_t new_page_id,
+                                         page_id_t &page_id) {
+        if (new_page_id == INVALID_PAGE_ID) {
+            // read-only database
+            return nullptr;
         }
-        latch_.unlock();
+        Instance &instance = GetInstance(new_page_id);
+        std::unique_lock<std::mutex> lock(instance.latch_);
+        Page *page;
+        bool stale = false;
+        instance.io_cv_.wait(lock, [&instance, new_page_id, &page, &stale] {
+            stale = instance.page_table_->Find(new_page_id, page);
+            return !stale || !page->is_io_;
+        });
+        if (stale) {
+            if (page->pin_count_++ == 0) {
+                instance.replacer_->Forget(page);
+            }
+            page->is_dirty_ = false;
+            page->is_io_ = true;
+        } else {
+            page = GetPage(instance, new_page_id, lock);
+        }
+        if (!page) {
+            lock.unlock();
+            disk_manager_->DeallocatePage(new_page_id);
+            return nullptr;
+        }
+        page->ResetMemory();
+        page->is_io_ = false;
+        instance.io_cv_.notify_all();
+        page_id = new_page_id;
         return page;
     }
 
-    Page *BufferPoolManager::GetPage() {
+    /*
+     * Point page at its contents in the read-only mapping of the db file,
+     * nothing is copied. Otherwise make sure page uses its own frame.
+     * @return: false if the page has to be read into its frame
+     */
+    bool BufferPoolManager::MapPage(Page *page) {
+        const char *data = disk_manager_->GetPageData(page->page_id_);
+        if (data == nullptr) {
+            page->data_ = frames_ + (page - pages_) * PAGE_SIZE;
+            return false;
+        }
+        // the mapping is read-only, writing to the page faults
+        page->data_ = const_cast<char *>(data);
+        return true;
+    }
+
+    BufferPoolManager::Instance &BufferPoolManager::GetInstance(page_id_t page_id) {
+        return instances_[static_cast<size_t>(page_id) % num_instances_];
+    }
+
+    /*
+     * Take a frame from free list or replacer and register it under page_id.
+     * The frame is returned pinned and marked as under I/O, the caller fills
+     * in its content and then clears is_io_. A dirty victim is written back
+     * with the latch released; until the write is done its page id stays in
+     * writing_ so that nobody reads a stale copy from disk.
+     */
+    Page *BufferPoolManager::GetPage(Instance &instance, page_id_t page_id,
+                                     std::unique_lock<std::mutex> &lock) {
         Page *page;
-        if (!free_list_->empty()) {
-            page = free_list_->front();
-            free_list_->pop_front();
+        if (!instance.free_list_->empty()) {
+            page = instance.free_list_->front();
+            instance.free_list_->pop_front();
         } else {
-            bool lruPop = replacer_->Victim(page);
+            bool lruPop = instance.replacer_->Victim(page);
             if (!lruPop) {
                 return nullptr;
             }
-            if (page->is_dirty_) {
-                disk_manager_->WritePage(page->page_id_, page->data_);
-            }
-            page_table_->Remove(page->page_id_);
+            instance.page_table_->Remove(page->page_id_);
+        }
+        page_id_t victim_page_id = page->page_id_;
+        bool victim_dirty = page->is_dirty_;
+        if (victim_dirty) {
+            // the background writer is behind, wake it up
+            flush_cv_.notify_one();
+        }
+
+        page->page_id_ = page_id;
+        page->pin_count_ = 1;
+        page->is_dirty_ = false;
+        page->is_io_ = true;
+        instance.page_table_->Insert(page_id, page);
+
+        if (victim_dirty) {
+            instance.io_cv_.wait(lock, [&instance, victim_page_id] {
+                return instance.writing_.count(victim_page_id) == 0;
+            });
+            instance.writing_.insert(victim_page_id);
+            lock.unlock();
+            disk_manager_->WritePage(victim_page_id, page->data_);
+            lock.lock();
+            instance.writing_.erase(victim_page_id);
+            instance.io_cv_.notify_all();
         }
         return page;
     }
+
+    /*
+     * Start the background writer. It wakes up every BUFFER_POOL_FLUSH_TIMEOUT,
+     * or earlier when a dirty victim had to be written on the fetching thread,
+     * and writes dirty unpinned frames ahead of eviction so that at least
+     * clean_ratio of the unpinned frames of every instance are clean.
+     */
+    void BufferPoolManager::RunFlushThread(double clean_ratio) {
+        assert(clean_ratio >= 0 && clean_ratio <= 1);
+        if (flush_running_) {
+            return;
+        }
+        clean_ratio_ = clean_ratio;
+        flush_running_ = true;
+        flush_thread_ = new std::thread([this] {
+            std::unique_lock<std::mutex> lock(flush_latch_);
+            while (flush_running_) {
+                flush_cv_.wait_for(lock, BUFFER_POOL_FLUSH_TIMEOUT);
+                if (!flush_running_) {
+                    break;
+                }
+                lock.unlock();
+                std::vector<WriteBack> batch;
+                for (size_t i = 0; i < num_instances_; ++i) {
+                    std::lock_guard<std::mutex> guard(instances_[i].latch_);
+                    CollectDirtyFrames(instances_[i], batch);
+                }
+                FinishWriteBack(batch);
+                lock.lock();
+            }
+        });
+    }
+
+    /*
+     * Stop and join the background writer
+     */
+    void BufferPoolManager::StopFlushThread() {
+        if (!flush_running_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(flush_latch_);
+            flush_running_ = false;
+        }
+        flush_cv_.notify_one();
+        flush_thread_->join();
+        delete flush_thread_;
+        flush_thread_ = nullptr;
+    }
+
+    /*
+     * Queue pages [first_page_id, first_page_id + num_pages) to be read into
+     * the buffer pool by the background reader, which is started on first
+     * use. Pages that were never allocated are skipped. The pages end up
+     * unpinned, a later FetchPage finds them in the page table, or waits for
+     * the read if it is still in flight.
+     */
+    void BufferPoolManager::PrefetchPages(page_id_t first_page_id,
+                                          size_t num_pages) {
+        if (disk_manager_->IsReadOnly()) {
+            // mapped pages are read ahead by the OS
+            disk_manager_->AdvisePrefetch(first_page_id, num_pages);
+            return;
+        }
+        std::lock_guard<std::mutex> guard(prefetch_latch_);
+        for (size_t i = 0; i < num_pages; ++i) {
+            page_id_t page_id = first_page_id + static_cast<page_id_t>(i);
+            if (page_id < 0 || page_id >= disk_manager_->GetNumPages()) {
+                break;
+            }
+            prefetch_queue_.push_back(page_id);
+        }
+        if (prefetch_queue_.empty()) {
+            return;
+        }
+        if (!prefetch_thread_) {
+            prefetch_running_ = true;
+            prefetch_thread_ = new std::thread([this] {
+                std::unique_lock<std::mutex> lock(prefetch_latch_);
+                while (true) {
+                    prefetch_cv_.wait(lock, [this] {
+                        return !prefetch_running_ || !prefetch_queue_.empty();
+                    });
+                    if (!prefetch_running_) {
+                        break;
+                    }
+                    // keep most frames free for foreground fetches while
+                    // the batch is in flight
+                    size_t batch_size = std::max<size_t>(1, pool_size_ / 4);
+                    std::vector<page_id_t> batch;
+                    while (!prefetch_queue_.empty() && batch.size() < batch_size) {
+                        batch.push_back(prefetch_queue_.front());
+                        prefetch_queue_.pop_front();
+                    }
+                    prefetch_busy_ = true;
+                    lock.unlock();
+                    PrefetchBatch(batch);
+                    lock.lock();
+                    prefetch_busy_ = false;
+                    prefetch_idle_cv_.notify_all();
+                }
+            });
+        }
+        prefetch_cv_.notify_one();
+    }
+
+    /*
+     * Wait until the background reader has drained its queue
+     */
+    void BufferPoolManager::WaitForPrefetch() {
+        std::unique_lock<std::mutex> lock(prefetch_latch_);
+        prefetch_idle_cv_.wait(lock, [this] {
+            return !prefetch_running_ ||
+                   (prefetch_queue_.empty() && !prefetch_busy_);
+        });
+    }
+
+    /*
+     * Drop one pin of a page whose read failed, the page leaves the page
+     * table and its frame goes back to the free list with the last pin.
+     * Required instance latch_ locked
+     */
+    void BufferPoolManager::DiscardPage(Instance &instance, Page *page) {
+        if (page->page_id_ != INVALID_PAGE_ID) {
+            instance.page_table_->Remove(page->page_id_);
+            page->page_id_ = INVALID_PAGE_ID;
+        }
+        if (--page->pin_count_ == 0) {
+            instance.replacer_->Forget(page);
+            page->ResetPage();
+            instance.free_list_->push_back(page);
+        }
+    }
+
+    /*
+     * Read the pages of batch into the buffer pool and leave them unpinned.
+     * All reads are submitted before waiting for any of them, so they are in
+     * flight together. Pages already buffered or being written back are
+     * skipped, and so are pages no frame is available for. Pages failing
+     * their checksum are dropped again. Reading a page ahead is not a
+     * reference to it, the replacer learns about the page on its first use
+     */
+    void BufferPoolManager::PrefetchBatch(const std::vector<page_id_t> &batch) {
+        std::vector<std::pair<Page *, std::future<bool>>> reads;
+        for (page_id_t page_id : batch) {
+            Instance &instance = GetInstance(page_id);
+            std::unique_lock<std::mutex> lock(instance.latch_);
+            Page *page;
+            if (instance.page_table_->Find(page_id, page) ||
+                instance.writing_.count(page_id) > 0) {
+                continue;
+            }
+            page = GetPage(instance, page_id, lock);
+            if (page) {
+                lock.unlock();
+                page->ResetMemory();
+                reads.emplace_back(page,
+                                   disk_manager_->ReadPageAsync(page_id, page->data_));
+            }
+        }
+        for (auto &read : reads) {
+            bool valid = read.second.get();
+            Page *page = read.first;
+            Instance &instance = GetInstance(page->page_id_);
+            std::lock_guard<std::mutex> guard(instance.latch_);
+            page->is_io_ = false;
+            instance.io_cv_.notify_all();
+            if (!valid) {
+                DiscardPage(instance, page);
+            } else if (--page->pin_count_ == 0) {
+                instance.replacer_->InsertUnreferenced(page);
+                instance.unpin_time_[page - instance.pages_] = ++instance.unpin_clock_;
+            }
+        }
+    }
+
+    /*
+     * Pick the dirty unpinned frames that have been unpinned the longest, just
+     * enough of them to bring the clean share of unpinned frames up to
+     * clean_ratio_, and start writing them back. Required instance latch_
+     * locked
+     */
+    void BufferPoolManager::CollectDirtyFrames(Instance &instance,
+                                               std::vector<WriteBack> &batch) {
+        size_t unpinned = 0;
+        std::vector<Page *> dirty;
+        for (size_t i = 0; i < instance.pool_size_; ++i) {
+            Page *page = &instance.pages_[i];
+            if (page->page_id_ == INVALID_PAGE_ID || page->pin_count_ > 0 ||
+                page->is_io_) {
+                continue;
+            }
+            ++unpinned;
+            if (page->is_dirty_ && instance.writing_.count(page->page_id_) == 0) {
+                dirty.push_back(page);
+            }
+        }
+        size_t target = static_cast<size_t>(std::ceil(clean_ratio_ * unpinned));
+        size_t clean = unpinned - dirty.size();
+        if (clean >= target) {
+            return;
+        }
+        size_t count = std::min(target - clean, dirty.size());
+        std::partial_sort(dirty.begin(), dirty.begin() + count, dirty.end(),
+                          [&instance](Page *a, Page *b) {
+                              return instance.unpin_time_[a - instance.pages_] <
+                                     instance.unpin_time_[b - instance.pages_];
+                          });
+        for (size_t i = 0; i < count; ++i) {
+            StartWriteBack(instance, dirty[i], batch);
+        }
+    }
+
+    /*
+     * Copy the content of page into batch and mark the page clean. Its page id
+     * stays in writing_ until FinishWriteBack is done with it. Required
+     * instance latch_ locked and no other write of the page in flight.
+     */
+    void BufferPoolManager::StartWriteBack(Instance &instance, Page *page,
+                                           std::vector<WriteBack> &batch) {
+        assert(instance.writing_.count(page->page_id_) == 0);
+        batch.emplace_back();
+        WriteBack &write_back = batch.back();
+        write_back.page_id_ = page->page_id_;
+        write_back.data_.assign(page->data_, page->data_ + PAGE_SIZE);
+        page->is_dirty_ = false;
+        instance.writing_.insert(page->page_id_);
+    }
+
+    /*
+     * Write every page of batch to disk, submitted in page id order so the
+     * writes are as sequential as possible and all in flight together, then
+     * release them. Must be called without
+     * holding any instance latch
+     * @return: number of pages written
+     */
+    size_t BufferPoolManager::FinishWriteBack(std::vector<WriteBack> &batch) {
+        std::sort(batch.begin(), batch.end(),
+                  [](const WriteBack &a, const WriteBack &b) {
+                      return a.page_id_ < b.page_id_;
+                  });
+        std::vector<std::future<void>> writes;
+        writes.reserve(batch.size());
+        for (auto &write_back : batch) {
+            writes.push_back(disk_manager_->WritePageAsync(
+                write_back.page_id_, write_back.data_.data()));
+        }
+        for (auto &write : writes) {
+            write.wait();
+        }
+        for (auto &write_back : batch) {
+            Instance &instance = GetInstance(write_back.page_id_);
+            std::lock_guard<std::mutex> guard(instance.latch_);
+            instance.writing_.erase(write_back.page_id_);
+            instance.io_cv_.notify_all();
+        }
+        return batch.size();
+    }
 } // namespace cmudb
@@ -0,0 +1,80 @@
+/**
+ * CLOCK implementation
+ */
+#include <cassert>
+
+#include "buffer/clock_replacer.h"
+
+namespace cmudb {
+
+    ClockReplacer::ClockReplacer(Page *frames, size_t num_frames)
+            : frames(frames), numFrames(num_frames), evictableCnt(0), hand(0) {
+        evictable = new std::atomic<bool>[numFrames];
+        referenced = new std::atomic<bool>[numFrames];
+        for (size_t i = 0; i < numFrames; ++i) {
+            evictable[i] = false;
+            referenced[i] = false;
+        }
+    }
+
+    ClockReplacer::~ClockReplacer() {
+        delete[] evictable;
+        delete[] referenced;
+    }
+
+    /*
+     * Frame becomes unpinned: make it a candidate and give it a second chance
+     */
+    void ClockReplacer::Insert(Page *const &value) {
+        size_t i = FrameIndex(value);
+        referenced[i] = true;
+        if (!evictable[i].exchange(true)) {
+            ++evictableCnt;
+        }
+    }
+
+    /*
+     * Sweep the hand over the frames, clearing reference bits, until an
+     * evictable frame without reference bit is found. Two full rounds are
+     * always enough unless frames are erased concurrently.
+     */
+    bool ClockReplacer::Victim(Page *&value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        for (size_t step = 0; step < 2 * numFrames && evictableCnt > 0; ++step) {
+            size_t i = hand;
+            hand = (hand + 1) % numFrames;
+            if (!evictable[i] || referenced[i].exchange(false)) {
+                continue;
+            }
+            if (evictable[i].exchange(false)) {
+                --evictableCnt;
+                value = &frames[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * Frame gets pinned: it is no longer a candidate, but remember the access
+     */
+    bool ClockReplacer::Erase(Page *const &value) {
+        size_t i = FrameIndex(value);
+        referenced[i] = true;
+        if (evictable[i].exchange(false)) {
+            --evictableCnt;
+            return true;
+        }
+        return false;
+    }
+
+    size_t ClockReplacer::Size() {
+        return evictableCnt;
+    }
+
+    size_t ClockReplacer::FrameIndex(Page *const &value) const {
+        assert(value >= frames && value < frames + numFrames);
+        return static_cast<size_t>(value - frames);
+    }
+
+} // namespace cmudb
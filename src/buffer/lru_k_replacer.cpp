@@ -0,0 +1,162 @@
+/**
+ * LRU-K implementation
+ */
+#include "buffer/lru_k_replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    template<typename T>
+    LRUKReplacer<T>::LRUKReplacer(size_t k, size_t correlated_period)
+            : k(k), correlatedPeriod(correlated_period), currentTime(0) {}
+
+    template<typename T>
+    LRUKReplacer<T>::~LRUKReplacer() {}
+
+    /*
+     * Record a reference to value and make it a candidate for eviction
+     */
+    template<typename T>
+    void LRUKReplacer<T>::Insert(const T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        size_t now = ++currentTime;
+        History &history = histories[value];
+        if (history.evictable) {
+            Dequeue(value, history);
+        }
+        if (history.refs.empty()) {
+            history.refs.push_front(now);
+        } else if (now - history.last > correlatedPeriod) {
+            // a new uncorrelated reference, the previous correlated period
+            // collapses into a single point in time
+            size_t shift = history.last - history.refs.front();
+            for (auto &ref : history.refs) {
+                ref += shift;
+            }
+            history.refs.push_front(now);
+            if (history.refs.size() > k) {
+                history.refs.pop_back();
+            }
+        }
+        history.last = now;
+        history.evictable = true;
+        Enqueue(value, history);
+    }
+
+    /*
+     * Evict the value with the largest backward k-distance, skipping values
+     * still inside their correlated reference period if possible
+     */
+    template<typename T>
+    bool LRUKReplacer<T>::Victim(T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (PopFrom(coldQueue, true, value) || PopFrom(hotQueue, true, value) ||
+            PopFrom(coldQueue, false, value) || PopFrom(hotQueue, false, value)) {
+            histories.erase(value);
+            return true;
+        }
+        return false;
+    }
+
+    /*
+     * Value is no longer a candidate for eviction, its history is kept
+     */
+    template<typename T>
+    bool LRUKReplacer<T>::Erase(const T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = histories.find(value);
+        if (it == histories.end() || !it->second.evictable) {
+            return false;
+        }
+        Dequeue(value, it->second);
+        it->second.evictable = false;
+        return true;
+    }
+
+    template<typename T>
+    size_t LRUKReplacer<T>::Size() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return coldQueue.size() + hotQueue.size();
+    }
+
+    /*
+     * Make value a candidate for eviction, keeping its history as it is
+     */
+    template<typename T>
+    void LRUKReplacer<T>::InsertUnreferenced(const T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        History &history = histories[value];
+        if (history.evictable) {
+            return;
+        }
+        history.evictable = true;
+        Enqueue(value, history);
+    }
+
+    /*
+     * Drop value and its history
+     */
+    template<typename T>
+    void LRUKReplacer<T>::Forget(const T &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        auto it = histories.find(value);
+        if (it == histories.end()) {
+            return;
+        }
+        if (it->second.evictable) {
+            Dequeue(value, it->second);
+        }
+        histories.erase(it);
+    }
+
+    /*
+     * Values without a reference queue up as cold ones referenced now
+     */
+    template<typename T>
+    void LRUKReplacer<T>::Enqueue(const T &value, History &history) {
+        if (history.refs.size() < k) {
+            history.queued =
+                    history.refs.empty() ? currentTime : history.refs.front();
+            coldQueue.emplace(history.queued, value);
+        } else {
+            history.queued = history.refs.back();
+            hotQueue.emplace(history.queued, value);
+        }
+    }
+
+    template<typename T>
+    void LRUKReplacer<T>::Dequeue(const T &value, const History &history) {
+        if (history.refs.size() < k) {
+            coldQueue.erase(std::make_pair(history.queued, value));
+        } else {
+            hotQueue.erase(std::make_pair(history.queued, value));
+        }
+    }
+
+    /*
+     * Pop the first value of queue, if eligibleOnly is set skip values that
+     * were referenced within the correlated reference period. Reference times
+     * are unique, so at most correlatedPeriod values are skipped.
+     */
+    template<typename T>
+    bool LRUKReplacer<T>::PopFrom(Queue &queue, bool eligibleOnly, T &value) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if (eligibleOnly &&
+                currentTime - histories[it->second].last <= correlatedPeriod) {
+                continue;
+            }
+            value = it->second;
+            queue.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    template
+    class LRUKReplacer<Page *>;
+
+    // test only
+    template
+    class LRUKReplacer<int>;
+
+} // namespace cmudb
@@ -18,18 +18,13 @@ namespace cmudb {
     template<typename T>
     void LRUReplacer<T>::Insert(const T &value) {
         mtx.lock();
-        size_t i = 0;
-        for (; i < queue.size(); ++i) {
-            if (queue[i] == value) {
-                break;
-            }
-        }
-        if (i == queue.size()) {
-            queue.push_back(value);
+        auto it = index.find(value);
+        if (it != index.end()) {
+            // already in LRU, move it to the most recently used end
+            queue.splice(queue.end(), queue, it->second);
         } else {
-            T tempValue = queue[i];
-            queue.erase(queue.begin() + i);
-            queue.push_back(tempValue);
+            queue.push_back(value);
+            index.emplace(value, std::prev(queue.end()));
         }
         mtx.unlock();
     }
@@ -46,6 +41,7 @@ namespace cmudb {
         } else {
             value = queue.front();
             queue.pop_front();
+            index.erase(value);
             mtx.unlock();
             return true;
         }
@@ -58,15 +54,11 @@ namespace cmudb {
     template<typename T>
     bool LRUReplacer<T>::Erase(const T &value) {
         mtx.lock();
-        size_t i = 0;
-        bool find = false;
-        while (i < queue.size()) {
-            if (queue[i] == value) {
-                queue.erase(queue.begin() + i);
-                find = true;
-            } else {
-                ++i;
-            }
+        auto it = index.find(value);
+        bool find = it != index.end();
+        if (find) {
+            queue.erase(it->second);
+            index.erase(it);
         }
         mtx.unlock();
         return find;
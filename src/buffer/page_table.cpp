@@ -0,0 +1,157 @@
+/**
+ * page_table.cpp
+ */
+
+#include <cassert>
+#include <thread>
+
+#include "buffer/page_table.h"
+
+namespace cmudb {
+
+    /*
+     * Keep the load factor at most 1/2 so probe sequences stay short
+     */
+    PageTable::PageTable(size_t capacity)
+            : capacity(capacity), count(0), sequence(0) {
+        size_t numSlots = 2;
+        shift = 63;
+        while (numSlots < capacity * 2) {
+            numSlots <<= 1;
+            --shift;
+        }
+        mask = numSlots - 1;
+        slots = new Slot[numSlots];
+        for (size_t i = 0; i < numSlots; ++i) {
+            slots[i].pageId.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+            slots[i].page.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    PageTable::~PageTable() {
+        delete[] slots;
+    }
+
+    /*
+     * Fibonacci hashing: multiply by 2^64 / golden ratio and keep the top bits
+     */
+    size_t PageTable::Home(page_id_t page_id) const {
+        uint64_t key = static_cast<uint32_t>(page_id);
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+    }
+
+    size_t PageTable::Probe(page_id_t page_id) const {
+        size_t i = Home(page_id);
+        while (true) {
+            page_id_t slotId = slots[i].pageId.load(std::memory_order_relaxed);
+            if (slotId == page_id || slotId == INVALID_PAGE_ID) {
+                return i;
+            }
+            i = (i + 1) & mask;
+        }
+    }
+
+    void PageTable::BeginWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void PageTable::EndWrite() {
+        sequence.store(sequence.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_release);
+    }
+
+    /*
+     * Lock free lookup: probe the slots between two reads of the sequence
+     * counter, and start over if a writer has been active in between
+     */
+    bool PageTable::Find(const page_id_t &page_id, Page *&page) {
+        while (true) {
+            size_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            bool found = false;
+            Page *result = nullptr;
+            // at most half of the slots are used, so an empty slot ends the
+            // probe even if the slots are read in the middle of a change
+            for (size_t i = Home(page_id);; i = (i + 1) & mask) {
+                page_id_t slotId = slots[i].pageId.load(std::memory_order_relaxed);
+                if (slotId == INVALID_PAGE_ID) {
+                    break;
+                }
+                if (slotId == page_id) {
+                    result = slots[i].page.load(std::memory_order_relaxed);
+                    found = true;
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                if (found) {
+                    page = result;
+                }
+                return found;
+            }
+        }
+    }
+
+    /*
+     * Remove by shifting the following entries of the probe sequence back, so
+     * no tombstone is left behind
+     */
+    bool PageTable::Remove(const page_id_t &page_id) {
+        std::lock_guard<std::mutex> guard(mtx);
+        size_t hole = Probe(page_id);
+        if (slots[hole].pageId.load(std::memory_order_relaxed) == INVALID_PAGE_ID) {
+            return false;
+        }
+        BeginWrite();
+        for (size_t i = (hole + 1) & mask;; i = (i + 1) & mask) {
+            page_id_t slotId = slots[i].pageId.load(std::memory_order_relaxed);
+            if (slotId == INVALID_PAGE_ID) {
+                break;
+            }
+            // an entry may move into the hole only if its home slot is not
+            // cyclically inside (hole, i]
+            size_t home = Home(slotId);
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole].pageId.store(slotId, std::memory_order_relaxed);
+                slots[hole].page.store(slots[i].page.load(std::memory_order_relaxed),
+                                       std::memory_order_relaxed);
+                hole = i;
+            }
+        }
+        slots[hole].pageId.store(INVALID_PAGE_ID, std::memory_order_relaxed);
+        slots[hole].page.store(nullptr, std::memory_order_relaxed);
+        EndWrite();
+        --count;
+        return true;
+    }
+
+    /*
+     * Insert or replace the frame of page_id
+     */
+    void PageTable::Insert(const page_id_t &page_id, Page *const &page) {
+        assert(page_id != INVALID_PAGE_ID);
+        std::lock_guard<std::mutex> guard(mtx);
+        size_t i = Probe(page_id);
+        bool exist = slots[i].pageId.load(std::memory_order_relaxed) == page_id;
+        assert(exist || count < capacity);
+        BeginWrite();
+        slots[i].page.store(page, std::memory_order_relaxed);
+        slots[i].pageId.store(page_id, std::memory_order_relaxed);
+        EndWrite();
+        if (!exist) {
+            ++count;
+        }
+    }
+
+    size_t PageTable::Size() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return count;
+    }
+
+} // namespace cmudb
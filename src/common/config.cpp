@@ -4,4 +4,9 @@ namespace cmudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  std::chrono::milliseconds BUFFER_POOL_FLUSH_TIMEOUT =
+   std::chrono::milliseconds(100);
+  size_t SCAN_PREFETCH_WINDOW = 4;
+  int PAGE_SIZE = MIN_PAGE_SIZE;
+  bool ENABLE_PAGE_COMPRESSION = false;
 }
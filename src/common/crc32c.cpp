@@ -0,0 +1,188 @@
+/**
+ * crc32c.cpp
+ */
+#include <cstring>
+#include <initializer_list>
+
+#include "common/crc32c.h"
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+namespace cmudb {
+
+// reflected Castagnoli polynomial
+static const uint32_t CRC32C_POLY = 0x82f63b78;
+
+// block lengths of the interleaved hardware streams, powers of two
+static const size_t CRC32C_LONG = 8192;
+static const size_t CRC32C_SHORT = 256;
+
+/**
+ * Lookup tables, built once. slice_ is for slicing-by-8, long_ and short_
+ * shift a crc over CRC32C_LONG and CRC32C_SHORT zero bytes, which is how the
+ * interleaved streams are joined
+ */
+struct Crc32cTables {
+  uint32_t slice_[8][256];
+  uint32_t long_[4][256];
+  uint32_t short_[4][256];
+
+  Crc32cTables() {
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = n;
+      for (int k = 0; k < 8; k++)
+        crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+      slice_[0][n] = crc;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      uint32_t crc = slice_[0][n];
+      for (int k = 1; k < 8; k++) {
+        crc = slice_[0][crc & 0xff] ^ (crc >> 8);
+        slice_[k][n] = crc;
+      }
+    }
+    BuildShift(long_, CRC32C_LONG);
+    BuildShift(short_, CRC32C_SHORT);
+  }
+
+  // product of 32x32 matrix over GF(2) and vector
+  static uint32_t MatrixTimes(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    for (; vec != 0; vec >>= 1, mat++) {
+      if (vec & 1)
+        sum ^= *mat;
+    }
+    return sum;
+  }
+
+  static void MatrixSquare(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++)
+      square[n] = MatrixTimes(mat, mat[n]);
+  }
+
+  // tables applying the operator of len zero bytes, len a power of two
+  static void BuildShift(uint32_t table[4][256], size_t len) {
+    uint32_t op[32], tmp[32];
+    // operator of one zero bit
+    tmp[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++)
+      tmp[n] = 1u << (n - 1);
+    // square up to one zero byte, then once per doubling of len
+    MatrixSquare(op, tmp);
+    MatrixSquare(tmp, op);
+    MatrixSquare(op, tmp);
+    for (; len > 1; len >>= 1) {
+      MatrixSquare(tmp, op);
+      memcpy(op, tmp, sizeof(op));
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+      table[0][n] = MatrixTimes(op, n);
+      table[1][n] = MatrixTimes(op, n << 8);
+      table[2][n] = MatrixTimes(op, n << 16);
+      table[3][n] = MatrixTimes(op, n << 24);
+    }
+  }
+};
+
+static const Crc32cTables &Tables() {
+  static const Crc32cTables tables;
+  return tables;
+}
+
+uint32_t Crc32cSoftware(const char *data, size_t size, uint32_t crc) {
+  const Crc32cTables &tables = Tables();
+  const unsigned char *next = reinterpret_cast<const unsigned char *>(data);
+  crc = ~crc;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (size >= 8) {
+    uint64_t word;
+    memcpy(&word, next, sizeof(word));
+    word ^= crc;
+    crc = tables.slice_[7][word & 0xff] ^ tables.slice_[6][(word >> 8) & 0xff] ^
+          tables.slice_[5][(word >> 16) & 0xff] ^
+          tables.slice_[4][(word >> 24) & 0xff] ^
+          tables.slice_[3][(word >> 32) & 0xff] ^
+          tables.slice_[2][(word >> 40) & 0xff] ^
+          tables.slice_[1][(word >> 48) & 0xff] ^ tables.slice_[0][word >> 56];
+    next += 8;
+    size -= 8;
+  }
+#endif
+  for (; size > 0; size--)
+    crc = tables.slice_[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+#if defined(__x86_64__)
+static inline uint32_t Shift(const uint32_t table[4][256], uint32_t crc) {
+  return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+         table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+/**
+ * The crc32 instruction has a latency of three cycles but a throughput of
+ * one, so three independent blocks are checksummed at once and joined
+ * afterwards
+ */
+__attribute__((target("sse4.2"))) static uint32_t
+Crc32cSse42(const char *data, size_t size, uint32_t crc) {
+  const Crc32cTables &tables = Tables();
+  const char *next = data;
+  uint64_t crc0 = ~crc;
+  while (size > 0 && reinterpret_cast<uintptr_t>(next) % 8 != 0) {
+    crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *next++);
+    size--;
+  }
+  for (size_t block : {CRC32C_LONG, CRC32C_SHORT}) {
+    const uint32_t(*shift)[256] =
+        block == CRC32C_LONG ? tables.long_ : tables.short_;
+    while (size >= 3 * block) {
+      uint64_t crc1 = 0, crc2 = 0;
+      const char *end = next + block;
+      do {
+        uint64_t word0, word1, word2;
+        memcpy(&word0, next, sizeof(word0));
+        memcpy(&word1, next + block, sizeof(word1));
+        memcpy(&word2, next + 2 * block, sizeof(word2));
+        crc0 = _mm_crc32_u64(crc0, word0);
+        crc1 = _mm_crc32_u64(crc1, word1);
+        crc2 = _mm_crc32_u64(crc2, word2);
+        next += 8;
+      } while (next < end);
+      crc0 = Shift(shift, static_cast<uint32_t>(crc0)) ^ crc1;
+      crc0 = Shift(shift, static_cast<uint32_t>(crc0)) ^ crc2;
+      next += 2 * block;
+      size -= 3 * block;
+    }
+  }
+  for (; size >= 8; size -= 8, next += 8) {
+    uint64_t word;
+    memcpy(&word, next, sizeof(word));
+    crc0 = _mm_crc32_u64(crc0, word);
+  }
+  for (; size > 0; size--)
+    crc0 = _mm_crc32_u8(static_cast<uint32_t>(crc0), *next++);
+  return ~static_cast<uint32_t>(crc0);
+}
+#endif
+
+bool Crc32cHardware() {
+#if defined(__x86_64__)
+  static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+  return has_sse42;
+#else
+  return false;
+#endif
+}
+
+uint32_t Crc32c(const char *data, size_t size, uint32_t crc) {
+#if defined(__x86_64__)
+  if (Crc32cHardware())
+    return Crc32cSse42(data, size, crc);
+#endif
+  return Crc32cSoftware(data, size, crc);
+}
+
+} // namespace cmudb
@@ -0,0 +1,158 @@
+/**
+ * lz4.cpp
+ */
+#include <cstdint>
+#include <cstring>
+
+#include "common/lz4.h"
+
+namespace cmudb {
+
+static const size_t LZ4_MIN_MATCH = 4;
+// the last 5 bytes are always literals, and the last match starts at least
+// 12 bytes before the end
+static const size_t LZ4_LAST_LITERALS = 5;
+static const size_t LZ4_MF_LIMIT = 12;
+static const size_t LZ4_MAX_DISTANCE = 65535;
+static const int LZ4_HASH_BITS = 12;
+
+static inline uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// length beyond the 4 bits of a token, in bytes of 255 and a remainder
+static inline bool WriteLength(uint8_t *&op, const uint8_t *oend, size_t len) {
+  for (; len >= 255; len -= 255) {
+    if (op >= oend)
+      return false;
+    *op++ = 255;
+  }
+  if (op >= oend)
+    return false;
+  *op++ = static_cast<uint8_t>(len);
+  return true;
+}
+
+// literals followed by a match, no match if match_len is 0
+static bool WriteSequence(uint8_t *&op, const uint8_t *oend,
+                          const uint8_t *literals, size_t literal_len,
+                          size_t distance, size_t match_len) {
+  if (op >= oend)
+    return false;
+  uint8_t *token = op++;
+  *token = static_cast<uint8_t>((literal_len < 15 ? literal_len : 15) << 4);
+  if (literal_len >= 15 && !WriteLength(op, oend, literal_len - 15))
+    return false;
+  if (static_cast<size_t>(oend - op) < literal_len)
+    return false;
+  memcpy(op, literals, literal_len);
+  op += literal_len;
+  if (match_len == 0)
+    return true;
+  if (oend - op < 2)
+    return false;
+  *op++ = static_cast<uint8_t>(distance);
+  *op++ = static_cast<uint8_t>(distance >> 8);
+  size_t len = match_len - LZ4_MIN_MATCH;
+  *token |= static_cast<uint8_t>(len < 15 ? len : 15);
+  return len < 15 || WriteLength(op, oend, len - 15);
+}
+
+size_t Lz4Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  const uint8_t *base = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *ip = base, *anchor = base, *end = base + size;
+  uint8_t *op = reinterpret_cast<uint8_t *>(dst);
+  const uint8_t *oend = op + capacity;
+  if (size > LZ4_MF_LIMIT) {
+    const uint8_t *match_start_limit = end - LZ4_MF_LIMIT;
+    const uint8_t *match_end_limit = end - LZ4_LAST_LITERALS;
+    // position of the last sequence with each hash
+    uint32_t table[1 << LZ4_HASH_BITS] = {0};
+    while (ip < match_start_limit) {
+      uint32_t sequence = Read32(ip);
+      uint32_t hash = Hash(sequence);
+      const uint8_t *ref = base + table[hash];
+      table[hash] = static_cast<uint32_t>(ip - base);
+      if (ref >= ip || static_cast<size_t>(ip - ref) > LZ4_MAX_DISTANCE ||
+          Read32(ref) != sequence) {
+        // step faster over data that does not compress
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+      const uint8_t *match_end = ip + LZ4_MIN_MATCH;
+      const uint8_t *ref_end = ref + LZ4_MIN_MATCH;
+      while (match_end < match_end_limit && *match_end == *ref_end) {
+        match_end++;
+        ref_end++;
+      }
+      if (!WriteSequence(op, oend, anchor, ip - anchor, ip - ref,
+                         match_end - ip))
+        return 0;
+      ip = anchor = match_end;
+    }
+  }
+  if (!WriteSequence(op, oend, anchor, end - anchor, 0, 0))
+    return 0;
+  return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+// length beyond the 4 bits of a token
+static inline bool ReadLength(const uint8_t *&ip, const uint8_t *iend,
+                              size_t &len) {
+  uint8_t byte;
+  do {
+    if (ip >= iend)
+      return false;
+    byte = *ip++;
+    len += byte;
+  } while (byte == 255);
+  return true;
+}
+
+bool Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size) {
+  const uint8_t *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *iend = ip + size;
+  uint8_t *base = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = base, *oend = base + dst_size;
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t literal_len = token >> 4;
+    if (literal_len == 15 && !ReadLength(ip, iend, literal_len))
+      return false;
+    if (literal_len > static_cast<size_t>(iend - ip) ||
+        literal_len > static_cast<size_t>(oend - op))
+      return false;
+    memcpy(op, ip, literal_len);
+    op += literal_len;
+    ip += literal_len;
+    // the last sequence has no match
+    if (ip == iend)
+      break;
+    if (iend - ip < 2)
+      return false;
+    size_t distance = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (distance == 0 || distance > static_cast<size_t>(op - base))
+      return false;
+    size_t match_len = token & 15;
+    if (match_len == 15 && !ReadLength(ip, iend, match_len))
+      return false;
+    match_len += LZ4_MIN_MATCH;
+    if (match_len > static_cast<size_t>(oend - op))
+      return false;
+    // byte by byte, a match may overlap the bytes it produces
+    const uint8_t *ref = op - distance;
+    for (size_t i = 0; i < match_len; i++)
+      op[i] = ref[i];
+    op += match_len;
+  }
+  return op == oend;
+}
+
+} // namespace cmudb
@@ -0,0 +1,306 @@
+/**
+ * async_io.cpp
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/logger.h"
+#include "disk/async_io.h"
+
+namespace cmudb {
+
+// submission queue entries of the io_uring backend
+static const unsigned IO_QUEUE_DEPTH = 64;
+// workers of the thread pool backend
+static const size_t IO_THREADS = 4;
+
+AsyncIO *AsyncIO::Create(int fd, bool use_io_uring) {
+  if (use_io_uring) {
+    IOUring *ring = IOUring::Create(fd, IO_QUEUE_DEPTH);
+    if (ring != nullptr) {
+      return ring;
+    }
+    LOG_DEBUG("io_uring not available, using thread pool");
+  }
+  return new IOThreadPool(fd, IO_THREADS);
+}
+
+/*****************************************************************************
+ * IO_URING
+ *****************************************************************************/
+IOUring *IOUring::Create(int fd, unsigned entries) {
+#ifdef __NR_io_uring_setup
+  IOUring *ring = new IOUring(fd);
+  if (ring->Setup(entries)) {
+    ring->reaper_ = new std::thread(&IOUring::Reap, ring);
+    return ring;
+  }
+  delete ring;
+#else
+  (void)fd;
+  (void)entries;
+#endif
+  return nullptr;
+}
+
+/**
+ * Create the ring and map its submission queue, completion queue and
+ * submission queue entries into memory
+ */
+bool IOUring::Setup(unsigned entries) {
+#ifdef __NR_io_uring_setup
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd_ < 0) {
+    return false;
+  }
+  entries_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = static_cast<struct io_uring_sqe *>(sqes);
+
+  char *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  char *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe *>(cq + params.cq_off.cqes);
+  return true;
+#else
+  (void)entries;
+  return false;
+#endif
+}
+
+/**
+ * Wait for every I/O in flight, a request with null user data wakes the
+ * reaper up once all others are done
+ */
+IOUring::~IOUring() {
+  if (reaper_ != nullptr) {
+    {
+      std::unique_lock<std::mutex> lock(latch_);
+      space_cv_.wait(lock, [this] { return in_flight_ < entries_; });
+      stop_ = true;
+      ++in_flight_;
+      Push(nullptr);
+    }
+    reaper_->join();
+    delete reaper_;
+  }
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+void IOUring::Submit(bool is_write, char *data, size_t size, off_t offset,
+                     Callback callback) {
+  Request *request = new Request{is_write, data,   size,
+                                 offset,   0,      {data, size},
+                                 std::move(callback)};
+  std::unique_lock<std::mutex> lock(latch_);
+  // never more in flight than the completion queue can hold
+  space_cv_.wait(lock, [this] { return in_flight_ < entries_; });
+  ++in_flight_;
+  Push(request);
+}
+
+/**
+ * Fill the next submission queue entry and hand it to the kernel. The slot
+ * is always free since the kernel consumes entries on io_uring_enter and at
+ * most entries_ requests are in flight. A null request is a no-op.
+ */
+void IOUring::Push(Request *request) {
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  struct io_uring_sqe *sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  if (request == nullptr) {
+    sqe->opcode = IORING_OP_NOP;
+    sqe->user_data = 0;
+  } else {
+    sqe->opcode = request->is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = fd_;
+    sqe->addr = reinterpret_cast<uintptr_t>(&request->iov_);
+    sqe->len = 1;
+    sqe->off = request->offset_ + request->done_;
+    sqe->user_data = reinterpret_cast<uintptr_t>(request);
+  }
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0) < 0) {
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+      break;
+    }
+  }
+}
+
+void IOUring::Reap() {
+  for (;;) {
+    unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      {
+        std::lock_guard<std::mutex> lock(latch_);
+        if (stop_ && in_flight_ == 0) {
+          return;
+        }
+      }
+      syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+              nullptr, 0);
+      continue;
+    }
+    struct io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+    Request *request = reinterpret_cast<Request *>(cqe->user_data);
+    int res = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+
+    {
+      // the request was pushed under latch_ too, which orders its fields
+      // for tools that can not see through the kernel
+      std::lock_guard<std::mutex> lock(latch_);
+      if (request != nullptr) {
+        if (res == -EINTR || res == -EAGAIN) {
+          res = 0;
+        } else if (res == 0) {
+          // end of file, or a write that makes no progress
+          res = request->is_write_ ? -EIO : 0;
+          if (!request->is_write_) {
+            request->size_ = request->done_;
+          }
+        }
+        if (res > 0) {
+          request->done_ += res;
+        }
+        if (res >= 0 && request->done_ < request->size_) {
+          // short transfer, resubmit the rest
+          request->iov_.iov_base = request->data_ + request->done_;
+          request->iov_.iov_len = request->size_ - request->done_;
+          Push(request);
+          continue;
+        }
+      }
+      --in_flight_;
+      space_cv_.notify_all();
+    }
+    if (request != nullptr) {
+      request->callback_(res < 0 ? res : request->done_);
+      delete request;
+    }
+  }
+}
+
+/*****************************************************************************
+ * THREAD POOL
+ *****************************************************************************/
+IOThreadPool::IOThreadPool(int fd, size_t num_threads) : fd_(fd) {
+  for (size_t i = 0; i < num_threads; ++i) {
+    workers_.emplace_back([this] {
+      for (;;) {
+        std::unique_lock<std::mutex> lock(latch_);
+        cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty()) {
+          return;
+        }
+        Request *request = queue_.front();
+        queue_.pop_front();
+        lock.unlock();
+
+        ssize_t result = 0;
+        while (request->done_ < request->size_) {
+          char *data = request->data_ + request->done_;
+          size_t size = request->size_ - request->done_;
+          off_t offset = request->offset_ + request->done_;
+          ssize_t rc = request->is_write_ ? pwrite(fd_, data, size, offset)
+                                          : pread(fd_, data, size, offset);
+          if (rc < 0 && errno == EINTR) {
+            continue;
+          }
+          if (rc < 0) {
+            result = -errno;
+            break;
+          }
+          if (rc == 0) {
+            result = request->is_write_ ? -EIO : 0;
+            break;
+          }
+          request->done_ += rc;
+        }
+        request->callback_(result < 0 ? result : request->done_);
+        delete request;
+      }
+    });
+  }
+}
+
+// workers drain the queue before they exit
+IOThreadPool::~IOThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void IOThreadPool::Submit(bool is_write, char *data, size_t size, off_t offset,
+                          Callback callback) {
+  Request *request = new Request{is_write, data,   size,
+                                 offset,   0,      {data, size},
+                                 std::move(callback)};
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    queue_.push_back(request);
+  }
+  cv_.notify_one();
+}
+
+} // namespace cmudb
@@ -1,26 +1,185 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
+#include <cerrno>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <memory>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
+#include "common/crc32c.h"
+#include "common/exception.h"
 #include "common/logger.h"
+#include "common/lz4.h"
 #include "disk/disk_manager.h"
 
 namespace cmudb {
 
 static char *buffer_used = nullptr;
 
+// db files open in the process, they all share PAGE_SIZE
+static std::mutex open_files_latch;
+static int num_open_files = 0;
+static int open_page_size = 0;
+
+// identifies the first bitmap page of a db file
+static const uint32_t DB_FILE_MAGIC = 0x31424443;
+// format flags in the header of the first bitmap page
+static const uint32_t DB_FILE_COMPRESSED = 0x1;
+// identifies a page slot holding a compressed page
+static const uint32_t COMPRESSED_PAGE_MAGIC = 0x5a4c4443;
+
+/**
+ * Direct I/O needs aligned buffers, pages held elsewhere than in buffer pool
+ * frames are copied through this per thread buffer
+ */
+static char *BounceBuffer() {
+  struct Buffer {
+    void *data = nullptr;
+    int size = 0;
+    ~Buffer() { free(data); }
+  };
+  static thread_local Buffer buffer;
+  if (buffer.size != PAGE_SIZE) {
+    free(buffer.data);
+    if (posix_memalign(&buffer.data, DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0)
+      buffer.data = nullptr;
+    buffer.size = PAGE_SIZE;
+  }
+  return static_cast<char *>(buffer.data);
+}
+
+static inline bool IsAligned(const char *data) {
+  return reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+/**
+ * Checksum of the page at offset of db file, seeded with its position so a
+ * page written at the wrong place doesn't verify either
+ */
+static inline uint32_t PageChecksum(off_t offset, const char *data) {
+  return Crc32c(data, PAGE_CONTENT_SIZE,
+                static_cast<uint32_t>(offset / PAGE_SIZE));
+}
+
+static inline void StampChecksum(off_t offset, char *data) {
+  uint32_t checksum = PageChecksum(offset, data);
+  memcpy(data + PAGE_CONTENT_SIZE, &checksum, sizeof(checksum));
+}
+
+/**
+ * A page that was allocated but never written reads back as zeros and has no
+ * checksum to verify
+ */
+static bool VerifyChecksum(off_t offset, const char *data) {
+  uint32_t checksum;
+  memcpy(&checksum, data + PAGE_CONTENT_SIZE, sizeof(checksum));
+  if (checksum == PageChecksum(offset, data)) {
+    return true;
+  }
+  return std::all_of(data, data + PAGE_SIZE, [](char c) { return c == 0; });
+}
+
+/**
+ * Compressed page format (size in byte), padded with zeros to whole sectors
+ * of DIRECT_IO_ALIGNMENT bytes:
+ *  -----------------------------------------------------------------
+ * | Magic (4) | CompressedSize (4) | LZ4 block of the page (CompressedSize)
+ *  -----------------------------------------------------------------
+ * A slot describes itself, the page map only tells how much of it to read.
+ * Returns the sectors of the compressed page in out, 0 if compression saves
+ * less than a sector and the page is stored as is
+ */
+static int CompressPage(const char *page_data, char *out) {
+  uint32_t header[2] = {COMPRESSED_PAGE_MAGIC, 0};
+  int capacity = PAGE_SIZE - DIRECT_IO_ALIGNMENT - sizeof(header);
+  if (capacity <= 0) {
+    return 0;
+  }
+  header[1] = Lz4Compress(page_data, PAGE_SIZE, out + sizeof(header),
+                          static_cast<size_t>(capacity));
+  if (header[1] == 0) {
+    return 0;
+  }
+  memcpy(out, header, sizeof(header));
+  int end = sizeof(header) + header[1];
+  int sectors = (end + DIRECT_IO_ALIGNMENT - 1) / DIRECT_IO_ALIGNMENT;
+  memset(out + end, 0, sectors * DIRECT_IO_ALIGNMENT - end);
+  return sectors;
+}
+
+/**
+ * Decode the first size bytes of the slot of the page at offset into
+ * page_data, which must not overlap in. The page map is not persisted
+ * before the page, so after a crash it may be stale: a compressed page is
+ * recognized by its magic, a slot read in full may also hold the page as
+ * is. False unless the checksum of the page matches, callers that read
+ * less than the whole slot read it again then.
+ */
+static bool DecodePage(off_t offset, const char *in, int size,
+                       char *page_data) {
+  uint32_t header[2];
+  memcpy(header, in, sizeof(header));
+  if (header[0] == COMPRESSED_PAGE_MAGIC &&
+      header[1] <= size - sizeof(header) &&
+      Lz4Decompress(in + sizeof(header), header[1], page_data, PAGE_SIZE) &&
+      VerifyChecksum(offset, page_data)) {
+    return true;
+  }
+  if (size < PAGE_SIZE) {
+    return false;
+  }
+  memcpy(page_data, in, PAGE_SIZE);
+  return VerifyChecksum(offset, page_data);
+}
+
+/**
+ * Bitmap page format (size in byte):
+ *  ---------------------------------------------------------------------
+ * | Magic (4) | PageSize (4) | Flags (4) | page bits (BITMAP_PAGE_BITS / 8)
+ *  ---------------------------------------------------------------------
+ *  --------------
+ * | extent bits |
+ *  --------------
+ * one bit per page it tracks, and one per extent telling whether the extent
+ * is owned by an object. The header of the first one gives the page size and
+ * format of the db file.
+ *
+ * Page map pages hold one byte per page, the sectors it is stored in.
+ */
+static inline size_t PageBit(page_id_t page_id) {
+  return page_id / BITMAP_PAGE_BITS * PAGE_SIZE * 8 +
+         BITMAP_PAGE_HEADER_SIZE * 8 + page_id % BITMAP_PAGE_BITS;
+}
+
+static inline size_t ExtentBit(size_t extent) {
+  return extent / BITMAP_PAGE_EXTENTS * PAGE_SIZE * 8 +
+         BITMAP_PAGE_HEADER_SIZE * 8 + BITMAP_PAGE_BITS +
+         extent % BITMAP_PAGE_EXTENTS;
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
+ * @input direct_io: open database file with O_DIRECT, falls back to buffered
+ * I/O if the file system does not support it
+ * @input read_only: open an existing database file for reading only and map
+ * it into memory, no log file is used
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io,
+                         bool read_only)
+    : db_fd_(-1), file_name_(db_file), db_file_size_(0), direct_io_(false),
+      read_only_(read_only), compressed_(false), block_size_(PAGE_SIZE),
+      map_data_(nullptr),
+      map_size_(0), async_io_(nullptr), next_page_id_(0), free_hint_(0),
+      num_flushes_(0), num_writes_(0), num_syncs_(0), num_bytes_read_(0),
+      num_bytes_written_(0), flush_log_(false), flush_log_f_(nullptr) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
@@ -28,6 +187,30 @@ DiskManager::DiskManager(const std::string &db_file)
   }
   log_name_ = file_name_.substr(0, n) + ".log";
 
+  if (read_only) {
+    db_fd_ = open(db_file.c_str(), O_RDONLY);
+    if (db_fd_ < 0) {
+      LOG_DEBUG("can't open db file: %s", strerror(errno));
+      return;
+    }
+    struct stat stat_buf;
+    if (fstat(db_fd_, &stat_buf) == 0 && stat_buf.st_size > 0) {
+      db_file_size_ = stat_buf.st_size;
+      void *data = mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_SHARED,
+                        db_fd_, 0);
+      if (data == MAP_FAILED) {
+        // pages are read with pread then
+        LOG_DEBUG("can't map db file: %s", strerror(errno));
+      } else {
+        map_data_ = static_cast<char *>(data);
+        map_size_ = stat_buf.st_size;
+      }
+    }
+    LoadAllocationMap();
+    async_io_ = AsyncIO::Create(db_fd_);
+    return;
+  }
+
   log_io_.open(log_name_,
                std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -42,62 +225,382 @@ DiskManager::DiskManager(const std::string &db_file)
                                 std::ios::out);
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  // create the file if it does not exist
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    if (db_fd_ < 0) {
+      LOG_DEBUG("direct I/O not supported: %s", strerror(errno));
+    } else {
+      direct_io_ = true;
+    }
   }
+  if (db_fd_ < 0)
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    LOG_DEBUG("can't open db file: %s", strerror(errno));
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0) {
+    db_file_size_ = stat_buf.st_size;
+    block_size_ = stat_buf.st_blksize;
+  }
+  LoadAllocationMap();
+  async_io_ = AsyncIO::Create(db_fd_);
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  // finishes pending asynchronous I/O
+  delete async_io_;
+  if (map_data_ != nullptr) {
+    munmap(map_data_, map_size_);
+  }
+  if (db_fd_ >= 0) {
+    {
+      std::lock_guard<std::mutex> guard(alloc_latch_);
+      WriteAllocationMap();
+      close(db_fd_);
+    }
+    std::lock_guard<std::mutex> guard(open_files_latch);
+    num_open_files--;
+  }
   log_io_.close();
 }
 
 /**
- * Write the contents of the specified page into disk file
+ * Write the contents of the specified page into disk file, after stamping its
+ * checksum into the trailer of page_data
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+void DiskManager::WritePage(page_id_t page_id, char *page_data) {
+  if (read_only_) {
+    LOG_DEBUG("db file is read-only");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  off_t offset = PageOffset(page_id);
+  if (!compressed_) {
+    WriteAt(offset, page_data);
+    num_bytes_written_ += PAGE_SIZE;
+    num_writes_++;
+    return;
+  }
+  StampChecksum(offset, page_data);
+  char *buffer = BounceBuffer();
+  int sectors = CompressPage(page_data, buffer);
+  if (sectors > 0) {
+    WriteBytes(offset, buffer, sectors * DIRECT_IO_ALIGNMENT);
+  } else {
+    WriteBytes(offset, page_data, PAGE_SIZE);
+  }
+  SetStoredSectors(page_id, sectors);
+  num_bytes_written_ += sectors > 0 ? sectors * DIRECT_IO_ALIGNMENT : PAGE_SIZE;
+  num_writes_++;
 }
 
 /**
- * Read the contents of the specified page into the given memory area
+ * Read the contents of the specified page into the given memory area, return
+ * false if its checksum doesn't match or the read failed. A page beyond the
+ * end of db file was never written, page_data is left as is.
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  off_t offset = PageOffset(page_id);
+  if (compressed_) {
+    return ReadCompressedPage(page_id, page_data);
+  }
+  int rc = ReadAt(offset, page_data);
+  if (rc < 0) {
+    LOG_DEBUG("I/O error while reading page %d", page_id);
+    return false;
+  }
+  if (rc == 0) {
+    // check if read beyond file length
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return true;
+  }
+  num_bytes_read_ += PAGE_SIZE;
+  if (!VerifyChecksum(offset, page_data)) {
+    LOG_DEBUG("checksum mismatch on page %d", page_id);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Private helper function to read a page of a compressed db file, as many
+ * sectors as the page map tells, or the whole slot if they don't decode
+ */
+bool DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  off_t offset = PageOffset(page_id);
+  int sectors;
+  {
+    std::lock_guard<std::mutex> guard(alloc_latch_);
+    sectors = GetStoredSectors(page_id);
+  }
+  int size = sectors > 0 ? sectors * DIRECT_IO_ALIGNMENT : PAGE_SIZE;
+  char *buffer = BounceBuffer();
+  int rc = ReadBytes(offset, buffer, size);
+  if (rc < 0) {
+    LOG_DEBUG("I/O error while reading page %d", page_id);
+    return false;
+  }
+  if (rc == 0) {
+    LOG_DEBUG("I/O error while reading");
+    return true;
+  }
+  num_bytes_read_ += size;
+  bool valid = DecodePage(offset, buffer, size, page_data);
+  if (!valid && size < PAGE_SIZE && ReadBytes(offset, buffer, PAGE_SIZE) > 0) {
+    num_bytes_read_ += PAGE_SIZE;
+    valid = DecodePage(offset, buffer, PAGE_SIZE, page_data);
+  }
+  if (!valid) {
+    LOG_DEBUG("checksum mismatch on page %d", page_id);
+  }
+  return valid;
+}
+
+/**
+ * Private helper function to write one page at offset of db file, stamping
+ * its checksum first
+ */
+void DiskManager::WriteAt(off_t offset, char *data) {
+  StampChecksum(offset, data);
+  WriteBytes(offset, data, PAGE_SIZE);
+}
+
+/**
+ * Private helper function to read one page at offset of db file
+ */
+int DiskManager::ReadAt(off_t offset, char *data) {
+  return ReadBytes(offset, data, PAGE_SIZE);
+}
+
+/**
+ * Private helper function to write size bytes at offset of db file, size is
+ * at most PAGE_SIZE and a multiple of DIRECT_IO_ALIGNMENT
+ */
+void DiskManager::WriteBytes(off_t offset, const char *data, int size) {
+  if (direct_io_ && !IsAligned(data)) {
+    char *buffer = BounceBuffer();
+    memcpy(buffer, data, size);
+    data = buffer;
+  }
+  int written = 0;
+  while (written < size) {
+    ssize_t rc = pwrite(db_fd_, data + written, size - written,
+                        offset + written);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (rc <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return;
+    }
+    written += rc;
+  }
+  GrowFileSize(offset + size);
+}
+
+/**
+ * Private helper function to read size bytes at offset of db file, bytes past
+ * the end of db file are zeroed. Returns the number of bytes read from db
+ * file, 0 if offset is beyond its end, or -1 on an I/O error.
+ */
+int DiskManager::ReadBytes(off_t offset, char *data, int size) {
+  if (offset >= db_file_size_) {
+    return 0;
+  }
+  if (offset + size <= static_cast<off_t>(map_size_)) {
+    memcpy(data, map_data_ + offset, size);
+    return size;
+  }
+  if (direct_io_ && !IsAligned(data)) {
+    char *buffer = BounceBuffer();
+    int rc = ReadBytes(offset, buffer, size);
+    if (rc > 0) {
+      memcpy(data, buffer, size);
+    }
+    return rc;
+  }
+  int read_count = 0;
+  while (read_count < size) {
+    ssize_t rc = pread(db_fd_, data + read_count, size - read_count,
+                       offset + read_count);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      LOG_DEBUG("I/O error while reading: %s", strerror(errno));
+      return -1;
+    }
+    if (rc == 0) {
+      break;
+    }
+    read_count += rc;
+  }
+  // if file ends before reading size bytes
+  if (read_count < size) {
+    LOG_DEBUG("Read less than a page");
+    // std::cerr << "Read less than a page" << std::endl;
+    memset(data + read_count, 0, size - read_count);
+  }
+  return read_count;
+}
+
+/**
+ * Asynchronous WritePage, the future is ready once the page is written
+ */
+std::future<void> DiskManager::WritePageAsync(page_id_t page_id,
+                                              char *page_data) {
+  auto done = std::make_shared<std::promise<void>>();
+  std::future<void> future = done->get_future();
+  if (read_only_) {
+    LOG_DEBUG("db file is read-only");
+    done->set_value();
+    return future;
+  }
+  off_t offset = PageOffset(page_id);
+  StampChecksum(offset, page_data);
+  char *buffer = page_data;
+  int size = PAGE_SIZE;
+  int sectors = 0;
+  if (compressed_ || (direct_io_ && !IsAligned(page_data))) {
+    void *aligned;
+    if (posix_memalign(&aligned, DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0) {
+      LOG_DEBUG("I/O error while writing");
+      done->set_value();
+      return future;
+    }
+    buffer = static_cast<char *>(aligned);
+    sectors = compressed_ ? CompressPage(page_data, buffer) : 0;
+    if (sectors > 0) {
+      size = sectors * DIRECT_IO_ALIGNMENT;
+    } else {
+      memcpy(buffer, page_data, PAGE_SIZE);
+    }
+  }
+  async_io_->Submit(
+      true, buffer, size, offset,
+      [this, done, buffer, page_data, page_id, offset, size,
+       sectors](ssize_t rc) {
+        if (rc < 0) {
+          LOG_DEBUG("I/O error while writing");
+        } else {
+          GrowFileSize(offset + size);
+          if (compressed_) {
+            SetStoredSectors(page_id, sectors);
+          }
+          num_bytes_written_ += size;
+          num_writes_++;
+        }
+        if (buffer != page_data) {
+          free(buffer);
+        }
+        done->set_value();
+      });
+  return future;
+}
+
+/**
+ * Asynchronous ReadPage, the future is ready once page_data is filled and
+ * tells whether its checksum matches
+ */
+std::future<bool> DiskManager::ReadPageAsync(page_id_t page_id,
+                                             char *page_data) {
+  auto done = std::make_shared<std::promise<bool>>();
+  std::future<bool> future = done->get_future();
+  off_t offset = PageOffset(page_id);
+  // check if read beyond file length
+  if (offset >= db_file_size_) {
+    LOG_DEBUG("I/O error while reading");
+    done->set_value(true);
+    return future;
+  }
+  if (map_data_ != nullptr) {
+    // nothing to wait for, copy from the mapping
+    done->set_value(ReadPage(page_id, page_data));
+    return future;
+  }
+  int sectors = 0;
+  if (compressed_) {
+    std::lock_guard<std::mutex> guard(alloc_latch_);
+    sectors = GetStoredSectors(page_id);
+  }
+  int size = sectors > 0 ? sectors * DIRECT_IO_ALIGNMENT : PAGE_SIZE;
+  char *buffer = page_data;
+  if (compressed_ || (direct_io_ && !IsAligned(page_data))) {
+    void *aligned;
+    if (posix_memalign(&aligned, DIRECT_IO_ALIGNMENT, PAGE_SIZE) != 0) {
+      LOG_DEBUG("I/O error while reading");
+      done->set_value(false);
+      return future;
+    }
+    buffer = static_cast<char *>(aligned);
+  }
+  async_io_->Submit(
+      false, buffer, size, offset,
+      [this, done, buffer, page_data, offset, page_id, size](ssize_t rc) {
+        if (rc < 0) {
+          // the frame must not pass for a page that was never written
+          LOG_DEBUG("I/O error while reading page %d", page_id);
+          if (buffer != page_data) {
+            free(buffer);
+          }
+          done->set_value(false);
+          return;
+        }
+        num_bytes_read_ += size;
+        // if file ends before reading size bytes
+        if (rc < size) {
+          memset(buffer + rc, 0, size - rc);
+        }
+        bool valid;
+        if (compressed_) {
+          valid = DecodePage(offset, buffer, size, page_data);
+          // a stale page map entry, the rest of the slot is read here
+          if (!valid && size < PAGE_SIZE &&
+              ReadBytes(offset, buffer, PAGE_SIZE) > 0) {
+            num_bytes_read_ += PAGE_SIZE;
+            valid = DecodePage(offset, buffer, PAGE_SIZE, page_data);
+          }
+        } else {
+          if (buffer != page_data) {
+            memcpy(page_data, buffer, PAGE_SIZE);
+          }
+          valid = VerifyChecksum(offset, page_data);
+        }
+        if (buffer != page_data) {
+          free(buffer);
+        }
+        if (!valid) {
+          LOG_DEBUG("checksum mismatch on page %d", page_id);
+        }
+        done->set_value(valid);
+      });
+  return future;
+}
+
+/**
+ * Write barrier: wait until the data of every page write completed before
+ * the call is on stable storage, together with the allocation bitmap. Page
+ * writes themselves are never synced.
+ */
+void DiskManager::Sync() {
+  if (read_only_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(alloc_latch_);
+    WriteAllocationMap();
+  }
+  while (fdatasync(db_fd_) < 0) {
+    if (errno != EINTR) {
+      LOG_DEBUG("I/O error while syncing: %s", strerror(errno));
+      return;
     }
   }
+  num_syncs_++;
 }
 
 /**
@@ -158,16 +661,395 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * Hands out the lowest deallocated page id outside owned extents, or grows
+ * the db by one page
+ */
+page_id_t DiskManager::AllocatePage() {
+  if (read_only_) {
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  page_id_t page_id = free_hint_;
+  page_id_t end = next_page_id_;
+  while (page_id < end) {
+    if (IsOwned(page_id / EXTENT_SIZE)) {
+      page_id = (page_id / EXTENT_SIZE + 1) * EXTENT_SIZE;
+    } else if (!IsAllocated(page_id)) {
+      break;
+    } else if (page_id % 8 == 0 && page_id + 8 <= end &&
+               alloc_map_[PageBit(page_id) / 8] == static_cast<char>(0xff)) {
+      // skip fully allocated bytes
+      page_id += 8;
+    } else {
+      ++page_id;
+    }
+  }
+  SetAllocated(page_id, true);
+  next_page_id_ = std::max(end, page_id + 1);
+  free_hint_ = page_id + 1;
+  return page_id;
+}
+
+/**
+ * Allocate a page for the object that owns the extent of near, keeping its
+ * pages in ascending order where possible. A new object (near is
+ * INVALID_PAGE_ID), or one whose extent is full, claims a whole free extent.
+ */
+page_id_t DiskManager::AllocateExtentPage(page_id_t near) {
+  if (read_only_) {
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  if (near >= 0 && IsOwned(near / EXTENT_SIZE)) {
+    page_id_t first = near / EXTENT_SIZE * EXTENT_SIZE;
+    for (page_id_t i = 1; i < EXTENT_SIZE; ++i) {
+      page_id_t page_id = first + (near - first + i) % EXTENT_SIZE;
+      if (!IsAllocated(page_id)) {
+        SetAllocated(page_id, true);
+        next_page_id_ = std::max<page_id_t>(next_page_id_, page_id + 1);
+        return page_id;
+      }
+    }
+  }
+  return ClaimExtent(near);
+}
+
+/**
+ * Private helper function to take a free extent for a new owner. The extent
+ * right after the one of near keeps the owner's pages contiguous, otherwise
+ * the lowest free extent is taken, or a new one at the end of the db.
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::ClaimExtent(page_id_t near) {
+  size_t end = (next_page_id_ + EXTENT_SIZE - 1) / EXTENT_SIZE;
+  size_t extent = near / EXTENT_SIZE + 1;
+  // the extent at the end of the db is free too
+  if (near < 0 || extent > end || IsOwned(extent) || !IsExtentFree(extent)) {
+    extent = 0;
+    while (extent < end && (IsOwned(extent) || !IsExtentFree(extent))) {
+      ++extent;
+    }
+  }
+  SetOwned(extent, true);
+  page_id_t page_id = extent * EXTENT_SIZE;
+  SetAllocated(page_id, true);
+  next_page_id_ = std::max<page_id_t>(next_page_id_, page_id + 1);
+  return page_id;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
- * Need bitmap in header page for tracking pages
+ * The page id is reused by a later allocation, an extent with no page left
+ * is given up by its owner. Free pages at the end lower the high-water mark,
+ * so scans only cover pages up to the last live one.
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(alloc_latch_);
+  if (read_only_ || page_id < 0 || page_id >= next_page_id_ || !IsAllocated(page_id)) {
+    return;
+  }
+  SetAllocated(page_id, false);
+  size_t extent = page_id / EXTENT_SIZE;
+  if (!IsOwned(extent)) {
+    free_hint_ = std::min(free_hint_, page_id);
+  } else if (IsExtentFree(extent)) {
+    SetOwned(extent, false);
+    free_hint_ = std::min<page_id_t>(free_hint_, extent * EXTENT_SIZE);
+  }
+  page_id_t end = next_page_id_;
+  while (end > 0 && !IsAllocated(end - 1)) {
+    --end;
+  }
+  next_page_id_ = end;
+}
+
+/**
+ * Private helper function to read the bitmap pages of an existing db file,
+ * after switching to the page size and format it was created with, and its
+ * page map pages if it is compressed. The high-water mark is one past the
+ * last allocated page or the last page in db file, whichever is higher.
+ * Throws if the page size differs from the one of the db files already open.
+ */
+void DiskManager::LoadAllocationMap() {
+  compressed_ = ENABLE_PAGE_COMPRESSION;
+  int page_size = PAGE_SIZE;
+  if (db_file_size_ > 0) {
+    std::vector<char> header(PAGE_SIZE);
+    ReadAt(0, header.data());
+    uint32_t format[3];
+    memcpy(format, header.data(), sizeof(format));
+    if (format[0] == DB_FILE_MAGIC && IsValidPageSize(format[1])) {
+      page_size = static_cast<int>(format[1]);
+      compressed_ = (format[2] & DB_FILE_COMPRESSED) != 0;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(open_files_latch);
+    // pages of the db files already open are laid out with their page size
+    if (num_open_files > 0 && page_size != open_page_size) {
+      if (map_data_ != nullptr) {
+        munmap(map_data_, map_size_);
+      }
+      close(db_fd_);
+      throw Exception(EXCEPTION_TYPE_MISMATCH_TYPE,
+                      "db file " + file_name_ + " has page size " +
+                          std::to_string(page_size) +
+                          ", other db files are open with page size " +
+                          std::to_string(open_page_size));
+    }
+    if (page_size != PAGE_SIZE) {
+      LOG_DEBUG("db file has page size %d", page_size);
+      PAGE_SIZE = page_size;
+    }
+    open_page_size = page_size;
+    num_open_files++;
+  }
+  size_t num_maps = (db_file_size_ + MapOffset(1) - 1) / MapOffset(1);
+  alloc_map_.assign(num_maps * PAGE_SIZE, 0);
+  dirty_maps_.assign(num_maps, false);
+  for (size_t i = 0; i < num_maps; ++i) {
+    ReadAt(MapOffset(i), &alloc_map_[i * PAGE_SIZE]);
+    if (!VerifyChecksum(MapOffset(i), &alloc_map_[i * PAGE_SIZE])) {
+      LOG_DEBUG("checksum mismatch on allocation bitmap %zu", i);
+    }
+  }
+  if (compressed_) {
+    page_map_.assign(num_maps * BITMAP_PAGE_BITS, 0);
+    dirty_page_maps_.assign(num_maps * PAGE_MAP_PAGES, false);
+    std::vector<char> map_page(PAGE_SIZE);
+    for (size_t i = 0; i < num_maps * PAGE_MAP_PAGES; ++i) {
+      off_t offset = MapOffset(i / PAGE_MAP_PAGES) +
+                     (i % PAGE_MAP_PAGES + 1) * PAGE_SIZE;
+      std::fill(map_page.begin(), map_page.end(), 0);
+      ReadAt(offset, map_page.data());
+      if (!VerifyChecksum(offset, map_page.data())) {
+        LOG_DEBUG("checksum mismatch on page map %zu", i);
+      }
+      size_t first = i / PAGE_MAP_PAGES * BITMAP_PAGE_BITS +
+                     i % PAGE_MAP_PAGES * PAGE_CONTENT_SIZE;
+      size_t count = std::min(static_cast<size_t>(PAGE_CONTENT_SIZE),
+                              (i / PAGE_MAP_PAGES + 1) * BITMAP_PAGE_BITS - first);
+      memcpy(&page_map_[first], map_page.data(), count);
+    }
+  }
+  page_id_t end = static_cast<page_id_t>(num_maps * BITMAP_PAGE_BITS);
+  while (end > 0 && !IsAllocated(end - 1)) {
+    --end;
+  }
+  // bitmap pages are only written back by Sync, pages allocated after the
+  // last one are still in db file after a crash and must not be handed out
+  page_id_t file_pages = 0;
+  if (num_maps > 0) {
+    off_t first = MapOffset(num_maps - 1) + MetaPages() * PAGE_SIZE;
+    file_pages = static_cast<page_id_t>((num_maps - 1) * BITMAP_PAGE_BITS);
+    if (db_file_size_ > first) {
+      file_pages += std::min<page_id_t>(
+          BITMAP_PAGE_BITS, (db_file_size_ - first + PAGE_SIZE - 1) / PAGE_SIZE);
+    }
+  }
+  if (!read_only_) {
+    for (page_id_t page_id = end; page_id < file_pages; ++page_id) {
+      SetAllocated(page_id, true);
+    }
+  }
+  next_page_id_ = std::max(end, file_pages);
+}
+
+/**
+ * Private helper function to write back changed bitmap and page map pages.
+ * Deallocated pages past the high-water mark are cut off db file, so they
+ * are not taken for allocated on the next open.
  */
-void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-  return;
+void DiskManager::WriteAllocationMap() {
+  off_t end = PageOffset(next_page_id_);
+  if (!read_only_ && end < db_file_size_) {
+    if (ftruncate(db_fd_, end) == 0) {
+      db_file_size_ = end;
+    } else {
+      LOG_DEBUG("can't truncate db file: %s", strerror(errno));
+    }
+  }
+  for (size_t i = 0; i < dirty_maps_.size(); ++i) {
+    if (dirty_maps_[i]) {
+      uint32_t format[3] = {DB_FILE_MAGIC, static_cast<uint32_t>(PAGE_SIZE),
+                            compressed_ ? DB_FILE_COMPRESSED : 0};
+      memcpy(&alloc_map_[i * PAGE_SIZE], format, sizeof(format));
+      WriteAt(MapOffset(i), &alloc_map_[i * PAGE_SIZE]);
+      dirty_maps_[i] = false;
+    }
+  }
+  std::vector<char> map_page;
+  for (size_t i = 0; i < dirty_page_maps_.size(); ++i) {
+    if (dirty_page_maps_[i]) {
+      size_t first = i / PAGE_MAP_PAGES * BITMAP_PAGE_BITS +
+                     i % PAGE_MAP_PAGES * PAGE_CONTENT_SIZE;
+      size_t count = std::min(static_cast<size_t>(PAGE_CONTENT_SIZE),
+                              (i / PAGE_MAP_PAGES + 1) * BITMAP_PAGE_BITS - first);
+      map_page.assign(PAGE_SIZE, 0);
+      memcpy(map_page.data(), &page_map_[first], count);
+      WriteAt(MapOffset(i / PAGE_MAP_PAGES) +
+                  (i % PAGE_MAP_PAGES + 1) * PAGE_SIZE,
+              map_page.data());
+      dirty_page_maps_[i] = false;
+    }
+  }
+}
+
+int DiskManager::GetStoredSectors(page_id_t page_id) const {
+  return static_cast<size_t>(page_id) < page_map_.size() ? page_map_[page_id]
+                                                         : 0;
+}
+
+/**
+ * Private helper function to record the sectors a page was just written in.
+ * When they are fewer than before, the rest of its slot is punched out of
+ * db file so cold compressed pages also take less disk space
+ */
+void DiskManager::SetStoredSectors(page_id_t page_id, int sectors) {
+  int old_sectors;
+  {
+    std::lock_guard<std::mutex> guard(alloc_latch_);
+    old_sectors = GetStoredSectors(page_id);
+    if (old_sectors != sectors) {
+      size_t map_index = page_id / BITMAP_PAGE_BITS;
+      if (page_map_.size() < (map_index + 1) * BITMAP_PAGE_BITS) {
+        page_map_.resize((map_index + 1) * BITMAP_PAGE_BITS, 0);
+        dirty_page_maps_.resize((map_index + 1) * PAGE_MAP_PAGES, false);
+      }
+      page_map_[page_id] = static_cast<uint8_t>(sectors);
+      dirty_page_maps_[map_index * PAGE_MAP_PAGES +
+                       page_id % BITMAP_PAGE_BITS / PAGE_CONTENT_SIZE] = true;
+    }
+  }
+  // only whole file system blocks can be given back, file systems without
+  // hole punching keep the slot allocated
+  off_t begin = (sectors * DIRECT_IO_ALIGNMENT + block_size_ - 1) /
+                block_size_ * block_size_;
+  if (sectors > 0 && begin < PAGE_SIZE &&
+      (old_sectors == 0 || old_sectors > sectors)) {
+    fallocate(db_fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+              PageOffset(page_id) + begin, PAGE_SIZE - begin);
+  }
+}
+
+bool DiskManager::IsAllocated(page_id_t page_id) const {
+  return TestBit(PageBit(page_id));
+}
+
+void DiskManager::SetAllocated(page_id_t page_id, bool allocated) {
+  SetBit(PageBit(page_id), allocated);
+}
+
+bool DiskManager::IsOwned(size_t extent) const {
+  return TestBit(ExtentBit(extent));
+}
+
+void DiskManager::SetOwned(size_t extent, bool owned) {
+  SetBit(ExtentBit(extent), owned);
+}
+
+bool DiskManager::IsExtentFree(size_t extent) const {
+  size_t byte = PageBit(extent * EXTENT_SIZE) / 8;
+  for (size_t i = byte; i < byte + EXTENT_SIZE / 8 && i < alloc_map_.size();
+       ++i) {
+    if (alloc_map_[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DiskManager::TestBit(size_t bit) const {
+  size_t byte = bit / 8;
+  return byte < alloc_map_.size() && (alloc_map_[byte] >> (bit % 8)) & 1;
+}
+
+void DiskManager::SetBit(size_t bit, bool value) {
+  size_t map_index = bit / (PAGE_SIZE * 8);
+  if (map_index >= dirty_maps_.size()) {
+    alloc_map_.resize((map_index + 1) * PAGE_SIZE, 0);
+    dirty_maps_.resize(map_index + 1, false);
+  }
+  char mask = static_cast<char>(1 << (bit % 8));
+  if (value) {
+    alloc_map_[bit / 8] |= mask;
+  } else {
+    alloc_map_[bit / 8] &= ~mask;
+  }
+  dirty_maps_[map_index] = true;
+}
+
+/**
+ * Returns high-water mark of allocated pages, valid page ids are below it
+ */
+page_id_t DiskManager::GetNumPages() const { return next_page_id_; }
+
+bool DiskManager::IsDirectIO() const { return direct_io_; }
+
+bool DiskManager::IsReadOnly() const { return read_only_; }
+
+bool DiskManager::IsCompressed() const { return compressed_; }
+
+/**
+ * Bitmap page map_index sits right before the pages it tracks, after its
+ * page map pages in a compressed db file:
+ * | bitmap 0 | page map 0 | page 0 ... page BITMAP_PAGE_BITS - 1 | bitmap 1 |
+ */
+int DiskManager::MetaPages() const {
+  return compressed_ ? 1 + PAGE_MAP_PAGES : 1;
+}
+
+off_t DiskManager::MapOffset(size_t map_index) const {
+  return static_cast<off_t>(map_index) * (BITMAP_PAGE_BITS + MetaPages()) *
+         PAGE_SIZE;
+}
+
+off_t DiskManager::PageOffset(page_id_t page_id) const {
+  return (static_cast<off_t>(page_id) +
+          (page_id / BITMAP_PAGE_BITS + 1) * MetaPages()) *
+         PAGE_SIZE;
+}
+
+/**
+ * Page sizes are powers of two between MIN_PAGE_SIZE and MAX_PAGE_SIZE
+ */
+bool DiskManager::IsValidPageSize(uint32_t page_size) {
+  return page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE &&
+         (page_size & (page_size - 1)) == 0;
+}
+
+/**
+ * Returns the contents of page_id inside the read-only mapping of db file,
+ * nullptr if db file is not mapped, the page lies beyond the mapping or is
+ * stored compressed
+ */
+const char *DiskManager::GetPageData(page_id_t page_id) const {
+  if (map_data_ == nullptr || page_id < 0 || GetStoredSectors(page_id) > 0) {
+    return nullptr;
+  }
+  off_t offset = PageOffset(page_id);
+  if (offset + PAGE_SIZE > static_cast<off_t>(map_size_) ||
+      !VerifyChecksum(offset, map_data_ + offset)) {
+    return nullptr;
+  }
+  return map_data_ + offset;
+}
+
+/**
+ * Let the OS read pages [first_page_id, first_page_id + num_pages) of the
+ * mapping ahead of their use
+ */
+void DiskManager::AdvisePrefetch(page_id_t first_page_id, size_t num_pages) {
+  if (map_data_ == nullptr || first_page_id < 0 || num_pages == 0) {
+    return;
+  }
+  off_t begin = PageOffset(first_page_id);
+  off_t end = PageOffset(first_page_id + num_pages - 1) + PAGE_SIZE;
+  end = std::min(end, static_cast<off_t>(map_size_));
+  // madvise needs a page aligned address
+  off_t aligned = begin / sysconf(_SC_PAGESIZE) * sysconf(_SC_PAGESIZE);
+  if (aligned < end) {
+    madvise(map_data_ + aligned, end - aligned, MADV_WILLNEED);
+  }
 }
 
 /**
@@ -175,11 +1057,28 @@ void DiskManager::DeallocatePage(__attribute__((unused)) page_id_t page_id) {
  */
 int DiskManager::GetNumFlushes() const { return num_flushes_; }
 
+/**
+ * Returns number of page writes and of syncs of db file made so far
+ */
+int DiskManager::GetNumWrites() const { return num_writes_; }
+int DiskManager::GetNumSyncs() const { return num_syncs_; }
+int64_t DiskManager::GetNumBytesRead() const { return num_bytes_read_; }
+int64_t DiskManager::GetNumBytesWritten() const { return num_bytes_written_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Private helper function to grow the cached size of db file to end
+ */
+void DiskManager::GrowFileSize(int64_t end) {
+  int64_t size = db_file_size_.load();
+  while (size < end && !db_file_size_.compare_exchange_weak(size, end)) {
+  }
+}
+
 /**
  * Private helper function to get disk file size
  */
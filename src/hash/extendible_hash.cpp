@@ -11,12 +11,21 @@ namespace cmudb {
      * array_size: fixed array size for each bucket
      */
     template<typename K, typename V>
-    ExtendibleHash<K, V>::ExtendibleHash(size_t size): bucketSize(size) {
-        auto *bucketPtr = new Bucket(size, 0);
-        bucketList = {bucketPtr};
+    ExtendibleHash<K, V>::ExtendibleHash(size_t size): bucketSize(size), bucketList(1) {
+        bucketList[0] = new Bucket(size, 0);
         globalDepth = 0;
     }
 
+    template<typename K, typename V>
+    ExtendibleHash<K, V>::~ExtendibleHash() {
+        // the slots of a bucket are contiguous in the directory
+        for (size_t i = 0; i < bucketList.size(); ++i) {
+            if (i == 0 || bucketList[i] != bucketList[i - 1]) {
+                delete bucketList[i].load();
+            }
+        }
+    }
+
     /*
      * helper function to calculate the hashing address of input key
      */
@@ -36,7 +45,10 @@ namespace cmudb {
      */
     template<typename K, typename V>
     int ExtendibleHash<K, V>::GetGlobalDepth() const {
-        return globalDepth;
+        dirLatch.RLock();
+        int depth = globalDepth;
+        dirLatch.RUnlock();
+        return depth;
     }
 
     /*
@@ -45,7 +57,13 @@ namespace cmudb {
      */
     template<typename K, typename V>
     int ExtendibleHash<K, V>::GetLocalDepth(int bucket_id) const {
-        return bucketList[bucket_id]->localDepth;
+        dirLatch.RLock();
+        Bucket *bucket = bucketList[bucket_id];
+        bucket->latch.lock();
+        int depth = bucket->localDepth;
+        bucket->latch.unlock();
+        dirLatch.RUnlock();
+        return depth;
     }
 
     /*
@@ -53,7 +71,10 @@ namespace cmudb {
      */
     template<typename K, typename V>
     int ExtendibleHash<K, V>::GetNumBuckets() const {
-        return static_cast<int>(bucketList.size());
+        dirLatch.RLock();
+        int num = static_cast<int>(bucketList.size());
+        dirLatch.RUnlock();
+        return num;
     }
 
     /*
@@ -61,108 +82,215 @@ namespace cmudb {
      */
     template<typename K, typename V>
     bool ExtendibleHash<K, V>::Find(const K &key, V &value) {
-        mtx.lock();
-        size_t h = HashKey(key);
-        for (auto kv : bucketList[h]->kvs) {
+        dirLatch.RLock();
+        Bucket *bucket = LockBucket(key);
+        bool found = false;
+        for (auto &kv : bucket->kvs) {
             if (key == kv.first) {
                 value = kv.second;
-                mtx.unlock();
-                return true;
+                found = true;
+                break;
             }
         }
-        mtx.unlock();
-        return false;
+        bucket->latch.unlock();
+        dirLatch.RUnlock();
+        return found;
     }
 
     /*
      * delete <key,value> entry in hash table
-     * Shrink & Combination is not required for this project
+     * A bucket left empty is merged with its buddy, and the directory is
+     * halved when no bucket is as deep as it any more. Both need the
+     * directory latched exclusively, since buckets are freed.
      */
     template<typename K, typename V>
     bool ExtendibleHash<K, V>::Remove(const K &key) {
-        mtx.lock();
-        size_t hk = HashKey(key);
-        for (size_t i = 0; i < bucketList[hk]->kvs.size(); ++i) {
-            if (bucketList[hk]->kvs[i].first == key) {
-                bucketList[hk]->kvs.erase(bucketList[hk]->kvs.begin() + i);
-                ++bucketList[hk]->freeCnt;
-                mtx.unlock();
-                return true;
+        dirLatch.RLock();
+        Bucket *bucket = LockBucket(key);
+        bool found = false;
+        for (size_t i = 0; i < bucket->kvs.size(); ++i) {
+            if (bucket->kvs[i].first == key) {
+                bucket->kvs.erase(bucket->kvs.begin() + i);
+                ++bucket->freeCnt;
+                found = true;
+                break;
             }
         }
-        mtx.unlock();
-        return false;
+        bool merge = found && bucket->kvs.empty() && bucket->localDepth > 0;
+        bucket->latch.unlock();
+        dirLatch.RUnlock();
+
+        if (merge) {
+            dirLatch.WLock();
+            MergeBucket(HashKey(key));
+            ShrinkDirectory();
+            dirLatch.WUnlock();
+        }
+        return found;
     }
 
     /*
      * insert <key,value> entry in hash table
      * Split & Redistribute bucket when there is overflow and if necessary increase
      * global depth
+     * Buckets are split under the directory read latch; only when a full
+     * bucket is as deep as the directory the insert starts over with the
+     * directory latched exclusively to double it.
      */
     template<typename K, typename V>
     void ExtendibleHash<K, V>::Insert(const K &key, const V &value) {
-        V val;
-        if (Find(key, val)) {
-            size_t hk = HashKey(key);
-            mtx.lock();
-            for (auto &kv : bucketList[hk]->kvs) {
-                if (kv.first == key) {
-                    kv.second = value;
-                    break;
+        dirLatch.RLock();
+        Bucket *bucket = LockBucket(key);
+        while (!InsertIntoBucket(bucket, key, value)) {
+            if (bucket->localDepth == globalDepth) {
+                bucket->latch.unlock();
+                dirLatch.RUnlock();
+
+                dirLatch.WLock();
+                while (true) {
+                    bucket = bucketList[HashKey(key)];
+                    if (InsertIntoBucket(bucket, key, value)) {
+                        break;
+                    }
+                    if (bucket->localDepth == globalDepth) {
+                        DoubleDirectory();
+                    }
+                    SplitBucket(bucket, HashKey(key));
                 }
+                dirLatch.WUnlock();
+                return;
             }
-            mtx.unlock();
-            return;
+            SplitBucket(bucket, HashKey(key));
+            bucket->latch.unlock();
+            bucket = LockBucket(key);
         }
+        bucket->latch.unlock();
+        dirLatch.RUnlock();
+    }
 
-        mtx.lock();
+    /*
+     * A bucket found through the directory may be split before its latch is
+     * acquired, so check that it still holds key and retry otherwise. Split
+     * buckets are reused as the lower buddy, never freed under a read latch.
+     */
+    template<typename K, typename V>
+    typename ExtendibleHash<K, V>::Bucket *ExtendibleHash<K, V>::LockBucket(const K &key) {
+        size_t hk = HashKey(key);
         while (true) {
-            size_t hk = HashKey(key);
             Bucket *bucket = bucketList[hk];
-            if (bucket->freeCnt > 0) {
-                InsertIntoBucket(bucket, key, value);
-                break;
-            } else if (bucket->localDepth == globalDepth) {
-                size_t bucketNum = bucketList.size();
-                std::vector<Bucket *> tempBucketList(bucketList);
-                for (size_t i = 0; i < bucketNum; ++i) {
-                    bucketList.push_back(nullptr);
-                }
-                for (size_t i = 0; i < bucketNum << 1; ++i) {
-                    bucketList[i] = tempBucketList[i >> 1];
-                }
-                ++globalDepth;
-                bucketList[hk << 1] = new Bucket(bucketSize, globalDepth);
-                bucketList[(hk << 1) + 1] = new Bucket(bucketSize, globalDepth);
-                for (auto &kv : bucket->kvs) {
-                    size_t hk = HashKey(kv.first);
-                    InsertIntoBucket(bucketList[hk], kv.first, kv.second);
-                }
-                delete bucket;
-            } else {
-                int deltaDepth = globalDepth - bucket->localDepth;
-                size_t stIndex = (hk >> deltaDepth) << deltaDepth;
-                size_t edIndex = ((hk >> deltaDepth) + 1) << deltaDepth;
-                size_t midIndex = stIndex + (edIndex - stIndex) / 2;
-                auto newBucket1 = new Bucket(bucketSize, bucket->localDepth + 1);
-                auto newBucket2 = new Bucket(bucketSize, bucket->localDepth + 1);
-                for (size_t i = stIndex; i < edIndex; ++i) {
-                    bucketList[i] = (i < midIndex) ? newBucket1 : newBucket2;
-                }
-                for (auto &kv : bucket->kvs) {
-                    size_t hk = HashKey(kv.first);
-                    InsertIntoBucket(bucketList[hk], kv.first, kv.second);
-                }
-                delete bucket;
+            bucket->latch.lock();
+            if (bucketList[hk] == bucket) {
+                return bucket;
             }
+            bucket->latch.unlock();
         }
-        mtx.unlock();
     }
 
     template<typename K, typename V>
-    void ExtendibleHash<K, V>::InsertIntoBucket(Bucket *const bucket, const K &key, const V &value) {
+    bool ExtendibleHash<K, V>::InsertIntoBucket(Bucket *const bucket, const K &key, const V &value) {
+        for (auto &kv : bucket->kvs) {
+            if (kv.first == key) {
+                kv.second = value;
+                return true;
+            }
+        }
+        if (bucket->freeCnt == 0) {
+            return false;
+        }
         --bucket->freeCnt;
         bucket->kvs.emplace_back(key, value);
+        return true;
+    }
+
+    /*
+     * The bucket owns a contiguous range of directory slots around hk, the
+     * upper half of it goes to a new buddy bucket. The buddy is filled before
+     * it is published in the directory.
+     */
+    template<typename K, typename V>
+    void ExtendibleHash<K, V>::SplitBucket(Bucket *bucket, size_t hk) {
+        int deltaDepth = globalDepth - bucket->localDepth;
+        size_t stIndex = (hk >> deltaDepth) << deltaDepth;
+        size_t edIndex = stIndex + (static_cast<size_t>(1) << deltaDepth);
+        size_t midIndex = stIndex + (edIndex - stIndex) / 2;
+        auto newBucket = new Bucket(bucketSize, bucket->localDepth + 1);
+        std::vector<std::pair<K, V>> kvs;
+        kvs.swap(bucket->kvs);
+        bucket->freeCnt = bucketSize;
+        for (auto &kv : kvs) {
+            Bucket *target = HashKey(kv.first) < midIndex ? bucket : newBucket;
+            --target->freeCnt;
+            target->kvs.push_back(std::move(kv));
+        }
+        ++bucket->localDepth;
+        for (size_t i = midIndex; i < edIndex; ++i) {
+            bucketList[i] = newBucket;
+        }
+    }
+
+    /*
+     * Merge the bucket at directory slot hk with its buddy, the bucket that
+     * owns the adjacent slot range of the same size, as long as both have
+     * the same local depth and their pairs fit into one bucket. The lower
+     * buddy is kept, as in SplitBucket.
+     */
+    template<typename K, typename V>
+    void ExtendibleHash<K, V>::MergeBucket(size_t hk) {
+        Bucket *bucket = bucketList[hk];
+        while (bucket->localDepth > 0) {
+            int deltaDepth = globalDepth - bucket->localDepth;
+            size_t prefix = hk >> deltaDepth;
+            Bucket *buddy = bucketList[(prefix ^ 1) << deltaDepth];
+            if (buddy->localDepth != bucket->localDepth ||
+                bucket->kvs.size() + buddy->kvs.size() > bucketSize) {
+                break;
+            }
+            Bucket *lower = (prefix & 1) ? buddy : bucket;
+            Bucket *upper = (prefix & 1) ? bucket : buddy;
+            for (auto &kv : upper->kvs) {
+                --lower->freeCnt;
+                lower->kvs.push_back(std::move(kv));
+            }
+            size_t stIndex = (prefix & ~static_cast<size_t>(1)) << deltaDepth;
+            size_t edIndex = stIndex + (static_cast<size_t>(2) << deltaDepth);
+            for (size_t i = stIndex; i < edIndex; ++i) {
+                bucketList[i] = lower;
+            }
+            --lower->localDepth;
+            delete upper;
+            bucket = lower;
+        }
+    }
+
+    /*
+     * Halve the directory while every pair of slots that doubling created
+     * points to the same bucket
+     */
+    template<typename K, typename V>
+    void ExtendibleHash<K, V>::ShrinkDirectory() {
+        while (globalDepth > 0) {
+            for (size_t i = 0; i < bucketList.size(); i += 2) {
+                if (bucketList[i] != bucketList[i + 1]) {
+                    return;
+                }
+            }
+            std::vector<std::atomic<Bucket *>> newBucketList(bucketList.size() >> 1);
+            for (size_t i = 0; i < newBucketList.size(); ++i) {
+                newBucketList[i] = bucketList[i << 1].load();
+            }
+            bucketList.swap(newBucketList);
+            --globalDepth;
+        }
+    }
+
+    template<typename K, typename V>
+    void ExtendibleHash<K, V>::DoubleDirectory() {
+        std::vector<std::atomic<Bucket *>> newBucketList(bucketList.size() << 1);
+        for (size_t i = 0; i < newBucketList.size(); ++i) {
+            newBucketList[i] = bucketList[i >> 1].load();
+        }
+        bucketList.swap(newBucketList);
+        ++globalDepth;
     }
 
     template
@@ -0,0 +1,142 @@
+#include <functional>
+#include <list>
+
+#include "hash/linear_hash.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    /*
+     * constructor
+     * size: average number of pairs per bucket that triggers a split
+     */
+    template<typename K, typename V>
+    LinearHash<K, V>::LinearHash(size_t size)
+            : bucketSize(size > 0 ? size : 1), roundSize(initBuckets), next(0), pairCnt(0),
+              buckets(initBuckets) {}
+
+    /*
+     * helper function to calculate the hashing address of input key, the low
+     * bits are used for addressing so mix all bits of the hash into them
+     */
+    template<typename K, typename V>
+    size_t LinearHash<K, V>::HashKey(const K &key) {
+        std::hash<K> hashFunc;
+        uint64_t h = hashFunc(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    template<typename K, typename V>
+    int LinearHash<K, V>::GetNumBuckets() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return static_cast<int>(buckets.size());
+    }
+
+    template<typename K, typename V>
+    size_t LinearHash<K, V>::Size() {
+        std::lock_guard<std::mutex> guard(mtx);
+        return pairCnt;
+    }
+
+    /*
+     * lookup function to find value associate with input key
+     */
+    template<typename K, typename V>
+    bool LinearHash<K, V>::Find(const K &key, V &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        for (auto &kv : buckets[BucketIndex(HashKey(key))]) {
+            if (kv.first == key) {
+                value = kv.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * delete <key,value> entry in hash table
+     * Buckets are not merged back
+     */
+    template<typename K, typename V>
+    bool LinearHash<K, V>::Remove(const K &key) {
+        std::lock_guard<std::mutex> guard(mtx);
+        Bucket &bucket = buckets[BucketIndex(HashKey(key))];
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            if (bucket[i].first == key) {
+                bucket[i] = std::move(bucket.back());
+                bucket.pop_back();
+                --pairCnt;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /*
+     * insert <key,value> entry in hash table, or update the value of key
+     * Buckets overflow until their turn to split comes, at most one bucket is
+     * split per insert
+     */
+    template<typename K, typename V>
+    void LinearHash<K, V>::Insert(const K &key, const V &value) {
+        std::lock_guard<std::mutex> guard(mtx);
+        Bucket &bucket = buckets[BucketIndex(HashKey(key))];
+        for (auto &kv : bucket) {
+            if (kv.first == key) {
+                kv.second = value;
+                return;
+            }
+        }
+        bucket.emplace_back(key, value);
+        ++pairCnt;
+        if (pairCnt > bucketSize * buckets.size()) {
+            SplitNext();
+        }
+    }
+
+    template<typename K, typename V>
+    size_t LinearHash<K, V>::BucketIndex(size_t h) const {
+        size_t index = h % roundSize;
+        if (index < next) {
+            index = h % (roundSize << 1);
+        }
+        return index;
+    }
+
+    /*
+     * Rehash the bucket under the split pointer with twice the round size,
+     * its pairs either stay or move to the new bucket at the end
+     */
+    template<typename K, typename V>
+    void LinearHash<K, V>::SplitNext() {
+        buckets.emplace_back();
+        Bucket &oldBucket = buckets[next];
+        Bucket &newBucket = buckets.back();
+        for (size_t i = 0; i < oldBucket.size();) {
+            if (HashKey(oldBucket[i].first) % (roundSize << 1) != next) {
+                newBucket.push_back(std::move(oldBucket[i]));
+                oldBucket[i] = std::move(oldBucket.back());
+                oldBucket.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        if (++next == roundSize) {
+            roundSize <<= 1;
+            next = 0;
+        }
+    }
+
+    template
+    class LinearHash<page_id_t, Page *>;
+
+    // test purpose
+    template
+    class LinearHash<int, std::string>;
+
+    template
+    class LinearHash<int, int>;
+} // namespace cmudb
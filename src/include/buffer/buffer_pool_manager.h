@@ -4,15 +4,37 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ *
+ * The pool can be split into several independent instances. A page always
+ * lives in instance (page_id % num_instances), and every instance owns its
+ * own latch, page table, replacer and free list, so threads working on pages
+ * of different instances never contend with each other.
+ *
+ * An optional background writer keeps part of the unpinned frames clean, so
+ * that a miss rarely has to write a dirty victim back first.
+ *
+ * Sequential scans can ask for pages ahead of time with PrefetchPages, they
+ * are read into unpinned frames by a background reader. Read-ahead and write
+ * back batches keep many disk I/Os in flight at once.
+ *
+ * Over a read-only disk manager, fetched pages point straight into its
+ * mapping of the db file instead of being copied into frames.
  */
 
 #pragma once
+#include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_table.h"
 #include "disk/disk_manager.h"
-#include "hash/extendible_hash.h"
 #include "logging/log_manager.h"
 #include "page/page.h"
 
@@ -20,7 +42,9 @@ namespace cmudb {
     class BufferPoolManager {
     public:
         BufferPoolManager(size_t pool_size, DiskManager *disk_manager,
-                          LogManager *log_manager = nullptr);
+                          LogManager *log_manager = nullptr,
+                          size_t num_instances = 1,
+                          ReplacerType replacer_type = ReplacerType::LRU);
 
         ~BufferPoolManager();
 
@@ -30,20 +54,100 @@ namespace cmudb {
 
         bool FlushPage(page_id_t page_id);
 
+        // write all dirty pages to disk, return number of pages written
+        size_t FlushAllPages(size_t *bytes_written = nullptr);
+
         Page *NewPage(page_id_t &page_id);
 
+        // new page in the extent of near, for pages scanned in order
+        Page *NewExtentPage(page_id_t &page_id, page_id_t near);
+
         bool DeletePage(page_id_t page_id);
 
+        // keep at least clean_ratio of the unpinned frames clean in background
+        void RunFlushThread(double clean_ratio);
+
+        void StopFlushThread();
+
+        // read pages [first_page_id, first_page_id + num_pages) in background
+        void PrefetchPages(page_id_t first_page_id, size_t num_pages);
+
+        // block until every page asked to prefetch so far has been read
+        void WaitForPrefetch();
+
     private:
-        Page *GetPage(); // get page from free_list_ or replacer_, required latch_ locked
+        // one independent slice of the buffer pool
+        struct Instance {
+            Page *pages_;      // first frame of this instance inside pages_
+            size_t pool_size_; // number of frames owned by this instance
+            HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
+            Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
+            std::list<Page *> *free_list_; // to find a free page for replacement
+            std::mutex latch_;             // to protect this instance
+            std::condition_variable io_cv_; // signaled when a page I/O finishes
+            std::unordered_set<page_id_t> writing_; // pages being written back
+            size_t unpin_clock_;                    // number of unpins so far
+            std::vector<size_t> unpin_time_;        // unpin clock of each frame's last unpin
+        };
+
+        // a page copied out of its frame, waiting to be written to disk
+        struct WriteBack {
+            page_id_t page_id_;
+            std::vector<char> data_;
+        };
 
-        size_t pool_size_; // number of pages in buffer pool
-        Page *pages_;      // array of pages
+        // instance responsible for page_id
+        Instance &GetInstance(page_id_t page_id);
+
+        // buffer allocated page new_page_id, set page_id on success
+        Page *InitNewPage(page_id_t new_page_id, page_id_t &page_id);
+
+        // use the read-only mapping as page content if there is one
+        bool MapPage(Page *page);
+
+        // get page from free_list_ or replacer_ and reserve it for page_id,
+        // required instance latch_ locked (released while writing a dirty victim)
+        Page *GetPage(Instance &instance, page_id_t page_id,
+                      std::unique_lock<std::mutex> &lock);
+
+        // pick dirty frames to write ahead of eviction, required instance latch_ locked
+        void CollectDirtyFrames(Instance &instance, std::vector<WriteBack> &batch);
+
+        // copy page out for write back, required instance latch_ locked
+        void StartWriteBack(Instance &instance, Page *page,
+                            std::vector<WriteBack> &batch);
+
+        // write batch in page id order, no latch may be held
+        size_t FinishWriteBack(std::vector<WriteBack> &batch);
+
+        // drop a pin of page after its read failed, required instance latch_ locked
+        void DiscardPage(Instance &instance, Page *page);
+
+        // load pages into unpinned frames unless they are already there
+        void PrefetchBatch(const std::vector<page_id_t> &batch);
+
+        size_t pool_size_;      // number of pages in buffer pool
+        size_t num_instances_;  // number of independent instances
+        Page *pages_;           // array of pages
+        char *frames_;          // page contents, DIRECT_IO_ALIGNMENT aligned
+        Instance *instances_;   // array of instances
         DiskManager *disk_manager_;
         LogManager *log_manager_;
-        HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
-        Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
-        std::list<Page *> *free_list_; // to find a free page for replacement
-        std::mutex latch_;             // to protect shared data structure
+
+        // background writer
+        std::thread *flush_thread_;
+        std::atomic<bool> flush_running_;
+        double clean_ratio_;
+        std::mutex flush_latch_;
+        std::condition_variable flush_cv_;
+
+        // background reader
+        std::thread *prefetch_thread_;
+        bool prefetch_running_;
+        bool prefetch_busy_;  // a batch is being read
+        std::deque<page_id_t> prefetch_queue_;
+        std::mutex prefetch_latch_;
+        std::condition_variable prefetch_cv_;
+        std::condition_variable prefetch_idle_cv_; // signaled after each batch
     };
 } // namespace cmudb
@@ -0,0 +1,47 @@
+/**
+ * clock_replacer.h
+ *
+ * Functionality: CLOCK approximation of LRU over the frame array of a buffer
+ * pool. Every frame has an evictable flag and a reference bit, both updated
+ * with atomic operations only, so pinning and unpinning a page never takes the
+ * replacer latch. The latch only serializes the clock hand inside Victim.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "buffer/replacer.h"
+#include "page/page.h"
+
+namespace cmudb {
+
+    class ClockReplacer : public Replacer<Page *> {
+    public:
+        // frames: first frame of the array managed by this replacer
+        ClockReplacer(Page *frames, size_t num_frames);
+
+        ~ClockReplacer();
+
+        void Insert(Page *const &value);
+
+        bool Victim(Page *&value);
+
+        bool Erase(Page *const &value);
+
+        size_t Size();
+
+    private:
+        size_t FrameIndex(Page *const &value) const;
+
+        Page *frames;
+        size_t numFrames;
+        std::atomic<bool> *evictable;  // frame is unpinned and may be victimized
+        std::atomic<bool> *referenced; // frame was used since the hand last passed
+        std::atomic<size_t> evictableCnt;
+        size_t hand;
+        std::mutex mtx; // protects hand
+    };
+
+} // namespace cmudb
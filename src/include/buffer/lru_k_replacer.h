@@ -0,0 +1,79 @@
+/**
+ * lru_k_replacer.h
+ *
+ * Functionality: LRU-K replacement (O'Neil et al.). The victim is the value
+ * whose K-th most recent reference is the oldest; values referenced fewer than
+ * K times go first, in LRU order. A single sequential scan therefore only
+ * replaces pages it has brought in itself and keeps the hot working set.
+ *
+ * A reference is recorded when a value is inserted (the page is unpinned).
+ * References that follow the previous one within the correlated reference
+ * period (e.g. one page being re-pinned for every tuple of a scan) count as a
+ * single reference, and a value stays ineligible for eviction within that
+ * period of its last reference unless nothing else can be evicted.
+ *
+ * History survives Erase (the page is pinned again) and is dropped when the
+ * value is chosen as victim or forgotten (the frame is freed). A value
+ * inserted unreferenced (a prefetched page) is evictable with no history, its
+ * first real use counts as its first reference.
+ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+#include "buffer/replacer.h"
+
+namespace cmudb {
+
+    template<typename T>
+    class LRUKReplacer : public Replacer<T> {
+    public:
+        // correlated_period: in number of references recorded by this replacer
+        LRUKReplacer(size_t k = 2, size_t correlated_period = 2);
+
+        ~LRUKReplacer();
+
+        void Insert(const T &value);
+
+        bool Victim(T &value);
+
+        bool Erase(const T &value);
+
+        size_t Size();
+
+        void InsertUnreferenced(const T &value);
+
+        void Forget(const T &value);
+
+    private:
+        class History {
+        public:
+            std::deque<size_t> refs; // uncorrelated reference times, most recent first
+            size_t last = 0;         // time of the last reference, correlated or not
+            size_t queued = 0;       // key of the value in its queue while evictable
+            bool evictable = false;
+        };
+        // evictable values keyed by the time their backward distance is measured from
+        typedef std::set<std::pair<size_t, T>> Queue;
+
+        void Enqueue(const T &value, History &history);
+
+        void Dequeue(const T &value, const History &history);
+
+        bool PopFrom(Queue &queue, bool eligibleOnly, T &value);
+
+        const size_t k;
+        const size_t correlatedPeriod;
+        size_t currentTime;
+        std::unordered_map<T, History> histories;
+        Queue coldQueue; // fewer than k references, by most recent reference
+        Queue hotQueue;  // k references, by k-th most recent reference
+        std::mutex mtx;
+    };
+
+} // namespace cmudb
@@ -5,13 +5,21 @@
  * all the pages that are unpinned and ready to be swapped. The simplest way to
  * implement LRU is a FIFO queue, but remember to dequeue or enqueue pages when
  * a page changes from unpinned to pinned, or vice-versa.
+ *
+ * The queue is a doubly linked list indexed by a hash map from value to its
+ * list node, so Insert, Victim and Erase all take constant time. The map is
+ * protected by the replacer's mutex, it needs no latch of its own.
  */
 
 #pragma once
 
-#include <deque>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 #include "buffer/replacer.h"
-#include "hash/extendible_hash.h"
+#include "common/config.h"
 
 namespace cmudb {
 
@@ -33,7 +41,8 @@ namespace cmudb {
 
     private:
         // add your member variables here
-        std::deque<T> queue;
+        std::list<T> queue; // least recently used at front
+        std::unordered_map<T, typename std::list<T>::iterator> index; // value -> node in queue
         std::mutex mtx;
     };
 
@@ -0,0 +1,67 @@
+/**
+ * page_table.h
+ *
+ * Functionality: map a page id to the frame holding it. The buffer pool never
+ * holds more pages than it has frames, so the table has a fixed capacity and
+ * uses open addressing with linear probing over a flat slot array.
+ *
+ * Writers are serialized by a mutex and publish their changes through a
+ * sequence counter, readers never lock: they probe the slots and retry if a
+ * writer was active meanwhile.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "common/config.h"
+#include "hash/hash_table.h"
+
+namespace cmudb {
+
+    class Page;
+
+    class PageTable : public HashTable<page_id_t, Page *> {
+    public:
+        // capacity: maximum number of pages stored at the same time
+        explicit PageTable(size_t capacity);
+
+        ~PageTable();
+
+        // lookup and modifier
+        bool Find(const page_id_t &page_id, Page *&page) override;
+
+        bool Remove(const page_id_t &page_id) override;
+
+        void Insert(const page_id_t &page_id, Page *const &page) override;
+
+        size_t Size();
+
+    private:
+        struct Slot {
+            std::atomic<page_id_t> pageId; // INVALID_PAGE_ID when empty
+            std::atomic<Page *> page;
+        };
+
+        // home slot of page_id
+        size_t Home(page_id_t page_id) const;
+
+        // slot holding page_id or the empty slot ending its probe sequence,
+        // required mtx locked
+        size_t Probe(page_id_t page_id) const;
+
+        void BeginWrite();
+
+        void EndWrite();
+
+        const size_t capacity;
+        size_t mask;       // number of slots - 1
+        int shift;         // 64 - log2(number of slots)
+        Slot *slots;
+        size_t count;      // number of pages stored
+        std::atomic<size_t> sequence; // odd while a writer is changing slots
+        std::mutex mtx;    // serialize writers
+    };
+
+} // namespace cmudb
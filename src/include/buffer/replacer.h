@@ -9,6 +9,9 @@
 
 namespace cmudb {
 
+// replacement policies the buffer pool manager can be constructed with
+enum class ReplacerType { LRU = 0, CLOCK, LRU_K };
+
 template <typename T> class Replacer {
 public:
   Replacer() {}
@@ -17,6 +20,10 @@ public:
   virtual bool Victim(T &value) = 0;
   virtual bool Erase(const T &value) = 0;
   virtual size_t Size() = 0;
+  // make value a candidate for eviction without counting it as a reference
+  virtual void InsertUnreferenced(const T &value) { Insert(value); }
+  // value is gone, forget it along with whatever is known about it
+  virtual void Forget(const T &value) { Erase(value); }
 };
 
 } // namespace cmudb
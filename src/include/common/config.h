@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 
 namespace cmudb {
@@ -16,15 +17,45 @@ extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
 extern std::atomic<bool> ENABLE_LOGGING;
 
+extern std::chrono::milliseconds BUFFER_POOL_FLUSH_TIMEOUT;
+
+extern size_t SCAN_PREFETCH_WINDOW; // pages read ahead by a sequential scan
+
+// size of a data page in byte, a format parameter of the database: set it
+// before creating a new db file, opening an existing one adopts its page size.
+// It is shared by all db files open in the process, a db file with another
+// page size is refused while others are open.
+extern int PAGE_SIZE;
+
+// store the pages of new db files compressed, a format parameter like
+// PAGE_SIZE: opening an existing db file keeps the format it was created with
+extern bool ENABLE_PAGE_COMPRESSION;
+
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
-#define PAGE_SIZE 512     // size of a data page in byte
+#define MIN_PAGE_SIZE 512   // smallest page size supported
+#define MAX_PAGE_SIZE 65536 // largest page size supported
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
 #define BUFFER_POOL_SIZE 10            // size of buffer pool
+#define MIN_BUFFER_POOL_SIZE 8         // frames pinned by a b+ tree insert
+#define DIRECT_IO_ALIGNMENT 512        // buffer & offset alignment of O_DIRECT
+#define EXTENT_SIZE 64                 // pages of an extent owned by one object
+#define PAGE_CHECKSUM_SIZE 4           // CRC32C trailer at the end of every page
+#define PAGE_CONTENT_SIZE                                                          \
+  (PAGE_SIZE - PAGE_CHECKSUM_SIZE) // bytes of a page available to its layout
+#define BITMAP_PAGE_HEADER_SIZE 12     // format header of a bitmap page
+#define BITMAP_PAGE_EXTENTS                                                        \
+  ((PAGE_CONTENT_SIZE - BITMAP_PAGE_HEADER_SIZE) * 8 /                             \
+   (EXTENT_SIZE + 1)) // extents tracked by one bitmap page
+#define BITMAP_PAGE_BITS                                                           \
+  (BITMAP_PAGE_EXTENTS * EXTENT_SIZE) // pages tracked by one bitmap page
+#define PAGE_MAP_PAGES                                                             \
+  ((BITMAP_PAGE_BITS + PAGE_CONTENT_SIZE - 1) /                                    \
+   PAGE_CONTENT_SIZE) // page map pages per bitmap page of a compressed db file
 
 typedef int32_t page_id_t; // page id type
 typedef int32_t txn_id_t;  // transaction id type
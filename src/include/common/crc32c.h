@@ -0,0 +1,25 @@
+/**
+ * crc32c.h
+ *
+ * CRC-32C (Castagnoli polynomial), the checksum of db pages. Uses the SSE4.2
+ * crc32 instruction on three interleaved streams when the CPU has it, and
+ * table driven slicing-by-8 otherwise.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cmudb {
+
+// checksum of data, continuing the checksum crc of preceding data
+uint32_t Crc32c(const char *data, size_t size, uint32_t crc = 0);
+
+// software implementation, always available
+uint32_t Crc32cSoftware(const char *data, size_t size, uint32_t crc = 0);
+
+// whether Crc32c uses the hardware instruction
+bool Crc32cHardware();
+
+} // namespace cmudb
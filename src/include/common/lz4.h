@@ -0,0 +1,23 @@
+/**
+ * lz4.h
+ *
+ * Fast LZ77 compression producing the LZ4 block format: sequences of a
+ * literal run followed by a match of at least 4 bytes within the last 64KB.
+ * Compression is greedy with a single hash table, trading ratio for speed.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace cmudb {
+
+// compress size bytes of src into dst, return compressed size, or 0 if it
+// does not fit in capacity bytes
+size_t Lz4Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+// decompress a block of size bytes, true if it expands to exactly dst_size
+// bytes; malformed input is rejected, never read or written out of bounds
+bool Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size);
+
+} // namespace cmudb
@@ -0,0 +1,118 @@
+/**
+ * async_io.h
+ *
+ * Asynchronous reads and writes on a file descriptor, so that many page I/Os
+ * can be in flight at once. Backed by io_uring, driven through the raw system
+ * calls, or by a pool of threads doing pread/pwrite where io_uring is not
+ * available. Short transfers are resubmitted until the whole buffer is done
+ * or the end of file is reached.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+namespace cmudb {
+
+class AsyncIO {
+public:
+  // called on an I/O thread with the number of bytes transferred, short only
+  // at end of file, or -errno
+  typedef std::function<void(ssize_t)> Callback;
+
+  virtual ~AsyncIO() {}
+
+  // transfer size bytes between data and offset of the file, data must stay
+  // valid until callback is called
+  virtual void Submit(bool is_write, char *data, size_t size, off_t offset,
+                      Callback callback) = 0;
+
+  // io_uring backend if use_io_uring and the kernel supports it, thread pool
+  // backend otherwise. Pending I/Os complete before the backend is deleted.
+  static AsyncIO *Create(int fd, bool use_io_uring = true);
+
+protected:
+  struct Request {
+    bool is_write_;
+    char *data_;
+    size_t size_;
+    off_t offset_;
+    size_t done_;  // bytes transferred so far
+    struct iovec iov_; // remaining part, used by io_uring
+    Callback callback_;
+  };
+};
+
+class IOUring : public AsyncIO {
+public:
+  // nullptr if io_uring can not be set up
+  static IOUring *Create(int fd, unsigned entries);
+
+  ~IOUring();
+
+  void Submit(bool is_write, char *data, size_t size, off_t offset,
+              Callback callback) override;
+
+private:
+  IOUring(int fd) : fd_(fd) {}
+
+  bool Setup(unsigned entries);
+
+  // queue request on the submission ring, required latch_ locked
+  void Push(Request *request);
+
+  // reap completions until stopped and nothing is in flight
+  void Reap();
+
+  int fd_;
+  int ring_fd_ = -1;
+  unsigned entries_ = 0;
+  // submission ring
+  void *sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  struct io_uring_sqe *sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+  // completion ring, may share the mapping of the submission ring
+  void *cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  struct io_uring_cqe *cqes_;
+
+  std::mutex latch_; // protect submission ring and counters below
+  std::condition_variable space_cv_;
+  unsigned in_flight_ = 0;
+  bool stop_ = false;
+  std::thread *reaper_ = nullptr;
+};
+
+class IOThreadPool : public AsyncIO {
+public:
+  IOThreadPool(int fd, size_t num_threads);
+
+  ~IOThreadPool();
+
+  void Submit(bool is_write, char *data, size_t size, off_t offset,
+              Callback callback) override;
+
+private:
+  int fd_;
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::deque<Request *> queue_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace cmudb
@@ -5,47 +5,178 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ *
+ * In direct I/O mode the db file is opened with O_DIRECT, bypassing the
+ * kernel page cache so that the buffer pool is the only cache of db pages.
+ *
+ * Pages can also be read and written asynchronously, many I/Os are then in
+ * flight at once through io_uring (or a thread pool if it is unavailable).
+ *
+ * Page writes are not durable until Sync is called, callers issue it only
+ * where durability ordering requires it (e.g. at the end of a checkpoint).
+ *
+ * Allocated pages are tracked in bitmap pages, one ahead of every
+ * BITMAP_PAGE_BITS pages of the db file. The first one also records the page
+ * size of the db file, which is adopted as PAGE_SIZE on open. All open db
+ * files share PAGE_SIZE, opening one with another page size than the db files
+ * already open throws. Deallocated pages are handed out again, and the number
+ * of pages in use is recovered from the bitmaps when the db file is reopened,
+ * or from the file size for pages allocated after the bitmaps were last
+ * synced.
+ *
+ * Every page written gets a CRC32C checksum in its trailer, reads verify it
+ * so torn or corrupt pages are reported instead of handed out.
+ *
+ * Pages are grouped in extents of EXTENT_SIZE contiguous pages. Objects that
+ * are scanned in page order (table heaps, B+ tree leaves) allocate with
+ * AllocateExtentPage and get extents of their own, so their pages are
+ * contiguous in the file. Other pages fill the extents nobody owns.
+ *
+ * In read-only mode the db file is mapped into memory, the buffer pool hands
+ * out pages pointing into the mapping and the OS page cache holds the data.
+ *
+ * A compressed db file stores each page LZ4 compressed at the start of its
+ * slot, in whole sectors of DIRECT_IO_ALIGNMENT bytes. Page map pages after
+ * each bitmap page record how many sectors every page takes, so reads and
+ * writes only move those, and the rest of the slot is punched out of the
+ * file when that frees whole file system blocks. Pages that don't compress by
+ * at least a sector are stored as is. A compressed slot starts with a magic
+ * and its length, so a page map left stale by a crash only costs a read of
+ * the whole slot.
+ * Frames in the buffer pool always hold uncompressed pages.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "disk/async_io.h"
 
 namespace cmudb {
 
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, bool direct_io = false,
+              bool read_only = false);
   ~DiskManager();
 
-  void WritePage(page_id_t page_id, const char *page_data);
-  void ReadPage(page_id_t page_id, char *page_data);
+  // stamps the checksum of page_data into its last PAGE_CHECKSUM_SIZE bytes
+  void WritePage(page_id_t page_id, char *page_data);
+  // false if the checksum of the page read doesn't match or the read failed
+  bool ReadPage(page_id_t page_id, char *page_data);
+  // page_data must stay valid until the returned future is ready
+  std::future<void> WritePageAsync(page_id_t page_id, char *page_data);
+  std::future<bool> ReadPageAsync(page_id_t page_id, char *page_data);
+  // make every page write and allocation completed so far durable
+  void Sync();
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
   page_id_t AllocatePage();
+  // allocate page in the extent owned by near, in a new extent of its own if
+  // near is INVALID_PAGE_ID or its extent is full
+  page_id_t AllocateExtentPage(page_id_t near);
   void DeallocatePage(page_id_t page_id);
 
+  // high-water mark of allocated pages, valid page ids are below it
+  page_id_t GetNumPages() const;
+  // false if direct I/O was asked for but the file system refused it
+  bool IsDirectIO() const;
+  bool IsReadOnly() const;
+  bool IsCompressed() const;
+  static bool IsValidPageSize(uint32_t page_size);
+  // contents of page_id in the read-only mapping, nullptr if not mapped or
+  // its checksum does not match
+  const char *GetPageData(page_id_t page_id) const;
+  // hint that pages of the mapping will be read soon
+  void AdvisePrefetch(page_id_t first_page_id, size_t num_pages);
   int GetNumFlushes() const;
+  int GetNumWrites() const;
+  int GetNumSyncs() const;
+  // bytes of page data moved from and to db file
+  int64_t GetNumBytesRead() const;
+  int64_t GetNumBytesWritten() const;
   bool GetFlushState() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
+  // bitmap pages, and page map pages in a compressed db file, ahead of every
+  // BITMAP_PAGE_BITS pages
+  int MetaPages() const;
+  off_t MapOffset(size_t map_index) const;
+  off_t PageOffset(page_id_t page_id) const;
+  // write a page at offset, stamping its checksum first
+  void WriteAt(off_t offset, char *data);
+  // bytes read, 0 if offset is beyond end of db file, -1 on an I/O error
+  int ReadAt(off_t offset, char *data);
+  void WriteBytes(off_t offset, const char *data, int size);
+  int ReadBytes(off_t offset, char *data, int size);
+  // ReadPage of a compressed db file, the page map is only a hint
+  bool ReadCompressedPage(page_id_t page_id, char *page_data);
+  void GrowFileSize(int64_t end);
+  // load bitmap pages and recover next_page_id_
+  void LoadAllocationMap();
+  // write bitmap and page map pages changed since last call, required
+  // alloc_latch_ locked
+  void WriteAllocationMap();
+  // sectors page_id is stored in, 0 if uncompressed, required alloc_latch_
+  // locked unless db file is read-only
+  int GetStoredSectors(page_id_t page_id) const;
+  // record the sectors of a page just written, punch out the rest of its slot
+  void SetStoredSectors(page_id_t page_id, int sectors);
+  // claim a free extent, preferring the one after the extent of near, and
+  // allocate its first page, required alloc_latch_ locked
+  page_id_t ClaimExtent(page_id_t near);
+  bool IsAllocated(page_id_t page_id) const;
+  void SetAllocated(page_id_t page_id, bool allocated);
+  bool IsOwned(size_t extent) const;
+  void SetOwned(size_t extent, bool owned);
+  // no page of extent is allocated
+  bool IsExtentFree(size_t extent) const;
+  bool TestBit(size_t bit) const;
+  void SetBit(size_t bit, bool value);
   int GetFileSize(const std::string &name);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // db file, pages are read & written at absolute offsets so concurrent
+  // page I/O needs no latch
+  int db_fd_;
   std::string file_name_;
+  // size of db file, only shrinks when the bitmaps are written back
+  std::atomic<int64_t> db_file_size_;
+  bool direct_io_;
+  bool read_only_;
+  bool compressed_;
+  // allocation unit of the file system holding db file
+  int block_size_;
+  // read-only mapping of db file
+  char *map_data_;
+  size_t map_size_;
+  AsyncIO *async_io_;
   std::atomic<page_id_t> next_page_id_;
+  // allocation bitmap pages, one bit per page id and one per owned extent,
+  // and which of them changed
+  std::mutex alloc_latch_;
+  std::vector<char> alloc_map_;
+  std::vector<bool> dirty_maps_;
+  page_id_t free_hint_; // no free page id outside owned extents below it
+  // sectors of each page of a compressed db file, and which page map pages
+  // changed, also protected by alloc_latch_
+  std::vector<uint8_t> page_map_;
+  std::vector<bool> dirty_page_maps_;
   int num_flushes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_syncs_;
+  std::atomic<int64_t> num_bytes_read_;
+  std::atomic<int64_t> num_bytes_written_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
 };
@@ -5,15 +5,27 @@
  * Functionality: The buffer pool manager must maintain a page table to be able
  * to quickly map a PageId to its corresponding memory location; or alternately
  * report that the PageId does not match any currently-buffered page.
+ *
+ * The directory is protected by a reader-writer latch and every bucket by its
+ * own latch. Lookups, inserts and bucket splits hold the directory latch in
+ * read mode plus the latch of the bucket involved, so they proceed in parallel
+ * on different buckets; only resizing the directory and merging buckets take
+ * it exclusively.
+ *
+ * Removing the last pair of a bucket merges it back with its buddy, and the
+ * directory shrinks again once no bucket needs its full depth, so the table
+ * gives memory back after a load spike.
  */
 
 #pragma once
 
+#include <atomic>
 #include <cstdlib>
 #include <mutex>
 #include <vector>
 #include <string>
 
+#include "common/rwmutex.h"
 #include "hash/hash_table.h"
 
 namespace cmudb {
@@ -24,6 +36,8 @@ namespace cmudb {
         // constructor
         ExtendibleHash(size_t size);
 
+        ~ExtendibleHash();
+
         // helper function to generate hash addressing
         size_t HashKey(const K &key);
 
@@ -50,12 +64,37 @@ namespace cmudb {
             std::vector<std::pair<K, V>> kvs;
             size_t freeCnt;
             int localDepth;
+            std::mutex latch;
             Bucket(size_t size, int localDepth): freeCnt(size), localDepth(localDepth) {}
         };
         int globalDepth;
-        std::vector<Bucket *> bucketList;
-        std::mutex mtx;
+        // directory entries are only replaced under a bucket latch, readers of
+        // other entries may be active at the same time
+        std::vector<std::atomic<Bucket *>> bucketList;
+        mutable RWMutex dirLatch;
+
+        // bucket holding key, returned with its latch locked,
+        // required dirLatch locked in read mode
+        Bucket *LockBucket(const K &key);
+
+        // insert into bucket, or update the value if key is there already,
+        // return false if bucket is full
+        bool InsertIntoBucket(Bucket * bucket, const K &key, const V &value);
+
+        // split bucket, found at directory slot hk, into two buddies of one
+        // more local depth, required bucket->localDepth < globalDepth, and
+        // bucket latched or dirLatch locked in write mode
+        void SplitBucket(Bucket *bucket, size_t hk);
+
+        // double the directory, required dirLatch locked in write mode
+        void DoubleDirectory();
+
+        // merge the bucket at directory slot hk with its buddy while possible,
+        // required dirLatch locked in write mode
+        void MergeBucket(size_t hk);
 
-        void InsertIntoBucket(Bucket * bucket, const K &key, const V &value);
+        // halve the directory while possible, required dirLatch locked in
+        // write mode
+        void ShrinkDirectory();
     };
 } // namespace cmudb
@@ -0,0 +1,62 @@
+/*
+ * linear_hash.h : implementation of in-memory hash table using linear hashing
+ *
+ * Functionality: same as ExtendibleHash, but the table grows one bucket at a
+ * time. Buckets are addressed by the hash modulo the current round size, the
+ * ones before the split pointer by the hash modulo twice the round size. When
+ * the average bucket holds more than the bucket size, the bucket under the
+ * split pointer is split and the pointer moves on, so no insert ever has to
+ * rebuild a directory. Buckets live in a deque, adding one never moves the
+ * others.
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <string>
+
+#include "hash/hash_table.h"
+
+namespace cmudb {
+
+    template<typename K, typename V>
+    class LinearHash : public HashTable<K, V> {
+    public:
+        // constructor, size: average number of pairs per bucket before a split
+        LinearHash(size_t size);
+
+        // helper function to generate hash addressing
+        size_t HashKey(const K &key);
+
+        int GetNumBuckets();
+
+        size_t Size();
+
+        // lookup and modifier
+        bool Find(const K &key, V &value) override;
+
+        bool Remove(const K &key) override;
+
+        void Insert(const K &key, const V &value) override;
+
+    private:
+        typedef std::vector<std::pair<K, V>> Bucket;
+
+        // index of the bucket holding hash value h, required mtx locked
+        size_t BucketIndex(size_t h) const;
+
+        // split the bucket under the split pointer, required mtx locked
+        void SplitNext();
+
+        const size_t bucketSize;
+        const size_t initBuckets = 4;
+        size_t roundSize;  // number of buckets at the start of this round
+        size_t next;       // split pointer, next bucket to split in this round
+        size_t pairCnt;    // number of pairs stored
+        std::deque<Bucket> buckets;
+        std::mutex mtx;
+    };
+} // namespace cmudb
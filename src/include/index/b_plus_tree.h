@@ -7,12 +7,32 @@
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ *
+ * Concurrency: lookups crab down with read latches, holding at most a page
+ * and its parent. Inserts & removes first descend the same way and write
+ * latch only the leaf; when the leaf would split or underflow they start
+ * over, crabbing with write latches and releasing all latched ancestors
+ * (kept in the page set of transaction) as soon as a page is safe, i.e. can
+ * not split or underflow. The root page id is protected by its own latch,
+ * held in write mode only by descents that may change the root.
+ * Leaves are latched left to right, the order of scans.
+ *
+ * B-link mode (Lehman & Yao): every page links to its right sibling and
+ * knows the high key bounding its keys, so a descent that finds its key at
+ * or beyond the high key of a page, which split after the descent read its
+ * parent, moves right. Lookups and writers hold one latch at a time. A split
+ * links the new page into its level first, releases the page, and inserts the
+ * separator into the parent afterwards, found again from the path taken down.
+ * Pages are never merged nor freed, removes only take keys out of leaves.
+ * Parent page ids are not kept, an index is always opened in the mode it was
+ * created in.
  */
 #pragma once
 
 #include <queue>
 #include <vector>
 
+#include "common/rwmutex.h"
 #include "concurrency/transaction.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -21,6 +41,13 @@
 namespace cmudb {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+
+// what a descent to a leaf is for, decides the latches taken on the way
+enum class Operation { READ = 0, INSERT, DELETE };
+
+// concurrency protocol of a tree
+enum class BPlusTreeMode { CRABBING = 0, B_LINK };
+
 // Main class providing the API for the Interactive B+ Tree.
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
@@ -28,7 +55,8 @@ public:
   explicit BPlusTree(const std::string &name,
                            BufferPoolManager *buffer_pool_manager,
                            const KeyComparator &comparator,
-                           page_id_t root_page_id = INVALID_PAGE_ID);
+                           page_id_t root_page_id = INVALID_PAGE_ID,
+                           BPlusTreeMode mode = BPlusTreeMode::CRABBING);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -58,21 +86,74 @@ public:
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
-  // expose for test purpose
+  // expose for test purpose, the leaf is returned pinned but not latched
   B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPage(const KeyType &key,
                                            bool leftMost = false);
 
 private:
+  // fetch pinned page, throw if buffer pool is out of frames
+  Page *FetchPage(page_id_t page_id);
+
+  // new pinned page in the extent of near_page_id, throw if buffer pool is
+  // out of frames
+  Page *NewPage(page_id_t &page_id, page_id_t near_page_id);
+
+  // crab down to the leaf of key with read latches, the leaf is write
+  // latched for op INSERT or DELETE; nullptr if tree is empty
+  Page *FindLeaf(const KeyType &key, bool left_most, Operation op);
+
+  // crab down to the leaf of key with write latches, latched pages and the
+  // root latch (as nullptr) are kept in the page set of transaction;
+  // nullptr if tree is empty
+  Page *FindLeafExclusive(const KeyType &key, Operation op,
+                          Transaction *transaction);
+
+  // whether op on node can not change its parent
+  bool IsSafe(BPlusTreePage *node, Operation op);
+
+  // unlatch and unpin everything in the page set, then delete the pages of
+  // the deleted page set
+  void ReleasePageSet(Transaction *transaction, bool is_dirty);
+
+  // page of page_id in the page set of transaction
+  Page *GetLatchedPage(page_id_t page_id, Transaction *transaction);
+
+  // 0 for leaves
+  int GetLevel(BPlusTreePage *node);
+
+  // right sibling of node if key is at or beyond its high key, otherwise
+  // INVALID_PAGE_ID
+  page_id_t MoveRight(BPlusTreePage *node, const KeyType &key);
+
+  // B-link mode: descend to the page of key at level, latching one page at a
+  // time, and push the internal pages passed through onto stack; the page is
+  // returned read latched, or write latched if exclusive
+  Page *FindPageBLink(const KeyType &key, bool left_most, int level,
+                      bool exclusive, std::vector<page_id_t> *stack);
+
+  bool InsertBLink(const KeyType &key, const ValueType &value);
+
+  // B-link mode: insert the separator key of a split of left_page_id at level
+  // into the parent, splitting upwards as needed
+  void InsertIntoParentBLink(std::vector<page_id_t> &stack,
+                             page_id_t left_page_id, int level,
+                             const KeyType &key, page_id_t right_page_id);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
                       Transaction *transaction = nullptr);
 
+  // new pages for the splits of an insert into the leaf of the page set,
+  // pushed top down; throw before any page changes if out of frames
+  void NewSplitPages(Transaction *transaction, std::vector<Page *> &new_pages);
+
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
                         BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+                        std::vector<Page *> &new_pages);
 
-  template <typename N> N *Split(N *node);
+  // move the upper half of node into page, a new page from NewPage()
+  template <typename N> N *Split(N *node, Page *page);
 
   template <typename N>
   bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
@@ -94,6 +175,8 @@ private:
   page_id_t root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
+  BPlusTreeMode mode_;
+  mutable RWMutex root_latch_;
 };
 
 } // namespace cmudb
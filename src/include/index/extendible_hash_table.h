@@ -0,0 +1,92 @@
+/**
+ * extendible_hash_table.h
+ *
+ * Disk-resident extendible hash table, the directory and the buckets are
+ * pages in the buffer pool, so a point lookup touches two pages whatever the
+ * size of the table.
+ * (1) We only support unique key
+ * (2) support insert, remove and point lookup
+ * (3) Buckets split and merge, the directory grows and shrinks dynamically,
+ *     up to DIRECTORY_MAX_DEPTH. A full bucket that can not split any more
+ *     links to overflow pages, so an insert only fails on a duplicate key.
+ *
+ * Concurrency: lookups, and inserts & removes that do not change the
+ * directory, hold the table latch in read mode and latch the one bucket page
+ * they touch, whose latch covers its overflow pages. Splits and merges latch
+ * the whole table exclusively. An exception (the buffer pool is out of
+ * frames) leaves with every latch and pin released.
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "common/rwmutex.h"
+#include "concurrency/transaction.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+#define HASH_TABLE_TYPE ExtendibleHashTable<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class ExtendibleHashTable {
+public:
+  explicit ExtendibleHashTable(const std::string &name,
+                               BufferPoolManager *buffer_pool_manager,
+                               const KeyComparator &comparator,
+                               page_id_t directory_page_id = INVALID_PAGE_ID);
+
+  // Insert a key-value pair, false if key is present
+  bool Insert(const KeyType &key, const ValueType &value,
+              Transaction *transaction = nullptr);
+
+  // Remove a key and its value
+  void Remove(const KeyType &key, Transaction *transaction = nullptr);
+
+  // return the value associated with a given key
+  bool GetValue(const KeyType &key, std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
+  // expose for test purpose
+  uint32_t GetGlobalDepth();
+
+private:
+  uint32_t Hash(const KeyType &key) const;
+
+  // fetch pinned page, throw if buffer pool is out of frames
+  Page *FetchPage(page_id_t page_id);
+
+  HashTableDirectoryPage *GetDirectory(Page *page);
+
+  HASH_TABLE_BUCKET_TYPE *GetBucket(Page *page);
+
+  // create directory and first bucket, required table_latch_ in write mode
+  void StartNewTable();
+
+  // insert splitting buckets as needed, required table_latch_ in write mode
+  bool SplitInsert(const KeyType &key, const ValueType &value);
+
+  // merge the bucket of key with its buddies and shrink the directory,
+  // required table_latch_ in write mode
+  void Merge(const KeyType &key);
+
+  // overflow chain of a bucket, required the bucket page latched (in write
+  // mode to modify it)
+  bool ChainLookup(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key,
+                   ValueType &value);
+  // false if the chain is full and overflow is not set
+  bool ChainInsert(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key,
+                   const ValueType &value, bool overflow);
+  bool ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket, const KeyType &key);
+
+  // member variable
+  std::string index_name_;
+  page_id_t directory_page_id_;
+  BufferPoolManager *buffer_pool_manager_;
+  KeyComparator comparator_;
+  RWMutex table_latch_;
+};
+
+} // namespace cmudb
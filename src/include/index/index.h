@@ -14,6 +14,9 @@
 
 namespace cmudb {
 
+// physical structure of an index
+enum class IndexType { BPLUSTREE = 0, HASH, BLINKTREE };
+
 /**
  * class IndexMetadata - Holds metadata of an index object
  *
@@ -28,8 +31,10 @@ class IndexMetadata {
 
 public:
   IndexMetadata(std::string index_name, std::string table_name,
-                const Schema *tuple_schema, const std::vector<int> &key_attrs)
-      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs) {
+                const Schema *tuple_schema, const std::vector<int> &key_attrs,
+                IndexType index_type = IndexType::BPLUSTREE)
+      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs),
+        index_type_(index_type) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
   }
 
@@ -39,6 +44,8 @@ public:
 
   inline const std::string &GetTableName() { return table_name_; }
 
+  inline IndexType GetIndexType() const { return index_type_; }
+
   // Returns a schema object pointer that represents the indexed key
   inline Schema *GetKeySchema() const { return key_schema_; }
 
@@ -57,7 +64,11 @@ public:
 
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
-       << "Type = B+Tree, "
+       << "Type = "
+       << (index_type_ == IndexType::HASH
+               ? "Hash"
+               : index_type_ == IndexType::BLINKTREE ? "B-link tree" : "B+Tree")
+       << ", "
        << "Table name = " << table_name_ << "] :: ";
     os << key_schema_->ToString();
 
@@ -71,6 +82,7 @@ private:
   const std::vector<int> key_attrs_;
   // schema of the indexed key
   Schema *key_schema_;
+  IndexType index_type_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -1,6 +1,13 @@
 /**
  * index_iterator.h
  * For range scan of b+ tree
+ *
+ * The iterator keeps its current leaf pinned and read latched, and crabs to
+ * the next leaf, so leaves are always latched left to right. The thread
+ * holding an iterator must not modify the tree before destroying it.
+ *
+ * Leaves are allocated in extents, so the leaves after the current one are
+ * read ahead by page id, SCAN_PREFETCH_WINDOW of them from the next leaf on.
  */
 #pragma once
 #include "page/b_plus_tree_leaf_page.h"
@@ -13,8 +20,13 @@ namespace cmudb {
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
-  // you may define your own constructor based on your member variables
+  // end of scan
   IndexIterator();
+  // at index of the leaf in page, which is pinned and read latched
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index);
+  IndexIterator(IndexIterator &&other);
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
   ~IndexIterator();
 
   bool isEnd();
@@ -24,7 +36,17 @@ public:
   IndexIterator &operator++();
 
 private:
-  // add your own private member variables here
+  // move on to the next leaf while the index is past the current one
+  void SkipExhaustedLeaves();
+  // keep the window of pages from the next leaf on in flight
+  void ReadAhead();
+  void Release();
+
+  BufferPoolManager *buffer_pool_manager_;
+  Page *page_;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
+  int index_;
+  page_id_t prefetch_end_; // one past the last page asked to prefetch
 };
 
 } // namespace cmudb
@@ -12,6 +12,14 @@
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ *
+ * Header adds to the common b+ tree page header:
+ *  --------------------------------------------------
+ * | NextPageId (4) | Level (4) | HighKey (key size) |
+ *  --------------------------------------------------
+ * NextPageId links the pages of a level left to right. All keys of the
+ * subtree are less than HighKey, which is +infinity for the last page of a
+ * level. Leaves are level 0.
  */
 
 #pragma once
@@ -36,11 +44,20 @@ public:
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
 
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  int GetLevel() const;
+  void SetLevel(int level);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                       const ValueType &new_value);
+  int Insert(const KeyType &new_key, const ValueType &new_value,
+             const KeyComparator &comparator);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
@@ -67,6 +84,12 @@ private:
                     BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
                      BufferPoolManager *buffer_pool_manager);
+  static BPlusTreeInternalPage *
+  FetchInternalPage(page_id_t page_id, BufferPoolManager *buffer_pool_manager);
+  void Adopt(page_id_t child_page_id, BufferPoolManager *buffer_pool_manager);
+  page_id_t next_page_id_;
+  int level_;
+  KeyType high_key_;
   MappingType array[0];
 };
 } // namespace cmudb
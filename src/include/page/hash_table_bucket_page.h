@@ -0,0 +1,61 @@
+/**
+ * hash_table_bucket_page.h
+ *
+ * Bucket page of the disk-resident extendible hash index. Holds unordered
+ * key & value pairs, only support unique key. A removed pair is replaced by
+ * the last one, so the pairs are always packed at the front.
+ * A bucket that can not split any more links to an overflow page, a bucket
+ * page of its own, which may link to the next one.
+ *
+ * Bucket page format (size in byte):
+ *  ---------------------------------------------------------------------
+ * | CurrentSize (4) | LSN (4) | NextPageId (4) | KEY(1) + RID(1) | ...
+ *  ---------------------------------------------------------------------
+ */
+#pragma once
+
+#include <vector>
+
+#include "page/b_plus_tree_page.h"
+
+namespace cmudb {
+#define HASH_TABLE_BUCKET_TYPE                                                 \
+  HashTableBucketPage<KeyType, ValueType, KeyComparator>
+
+INDEX_TEMPLATE_ARGUMENTS
+class HashTableBucketPage {
+public:
+  // After creating a new bucket page from buffer pool, must call initialize
+  // method to set default values
+  void Init();
+
+  // number of pairs fitting in a page
+  static int GetMaxSize();
+  int GetSize() const;
+  bool IsFull() const;
+  bool IsEmpty() const;
+  lsn_t GetLSN() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+  // overflow page, INVALID_PAGE_ID if none
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+
+  KeyType KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  // false if key is present or the bucket is full
+  bool Insert(const KeyType &key, const ValueType &value,
+              const KeyComparator &comparator);
+  bool Remove(const KeyType &key, const KeyComparator &comparator);
+  // remove the pair at index, the last pair takes its place
+  void RemoveAt(int index);
+
+private:
+  int size_;
+  lsn_t lsn_;
+  page_id_t next_page_id_;
+  MappingType array[0];
+};
+} // namespace cmudb
@@ -0,0 +1,81 @@
+/**
+ * hash_table_directory_page.h
+ *
+ * Directory page of the disk-resident extendible hash index. Slot i of the
+ * directory holds the bucket page for keys whose hash has i as its lowest
+ * GlobalDepth bits, together with the local depth of that bucket. Every
+ * bucket owns all the slots that agree with it on its lowest LocalDepth bits.
+ *
+ * Directory page format (size in byte):
+ *  ---------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | GlobalDepth (4) | BucketPageId(1) (4) | ...
+ *  ---------------------------------------------------------------------
+ *  ----------------------------------------------------------
+ * | BucketPageId(n) (4) | LocalDepth(1) (1) | ... | LocalDepth(n) (1)
+ *  ----------------------------------------------------------
+ * where n = 2^DIRECTORY_MAX_DEPTH, the largest directory fitting in the
+ * PAGE_CONTENT_SIZE bytes of a page
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace cmudb {
+
+// largest depth such that a directory of 2^depth slots fits in a page
+inline uint32_t DirectoryMaxDepth() {
+  uint32_t depth = 0;
+  while (12 + 5 * (2u << depth) <= static_cast<uint32_t>(PAGE_CONTENT_SIZE))
+    depth++;
+  return depth;
+}
+
+#define DIRECTORY_MAX_DEPTH DirectoryMaxDepth()
+#define DIRECTORY_ARRAY_SIZE (1u << DIRECTORY_MAX_DEPTH)
+
+class HashTableDirectoryPage {
+public:
+  // After creating a new directory page from buffer pool, must call
+  // initialize method to set default values: one slot pointing to bucket
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  page_id_t GetPageId() const;
+  lsn_t GetLSN() const;
+  void SetLSN(lsn_t lsn = INVALID_LSN);
+
+  // number of slots in use, 2^GlobalDepth
+  uint32_t Size() const;
+  uint32_t GetGlobalDepth() const;
+  // lowest GlobalDepth bits set
+  uint32_t GetGlobalDepthMask() const;
+  // double the directory, the new upper half mirrors the lower half
+  void IncrGlobalDepth();
+  // halve the directory, required CanShrink()
+  void DecrGlobalDepth();
+  // true if no bucket uses all GlobalDepth bits
+  bool CanShrink() const;
+
+  page_id_t GetBucketPageId(uint32_t bucket_idx) const;
+  void SetBucketPageId(uint32_t bucket_idx, page_id_t bucket_page_id);
+  uint32_t GetLocalDepth(uint32_t bucket_idx) const;
+  void SetLocalDepth(uint32_t bucket_idx, uint32_t local_depth);
+
+  // slot of the buddy bucket, the one differing in the highest bit of the
+  // local depth of bucket_idx, required local depth > 0
+  uint32_t GetSplitImageIndex(uint32_t bucket_idx) const;
+
+private:
+  page_id_t page_id_;
+  lsn_t lsn_;
+  uint32_t global_depth_;
+  // DIRECTORY_ARRAY_SIZE of them, followed by the local depths
+  page_id_t bucket_page_ids_[0];
+
+  uint8_t *LocalDepths();
+  const uint8_t *LocalDepths() const;
+};
+
+} // namespace cmudb
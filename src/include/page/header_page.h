@@ -32,6 +32,8 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  // number of records fitting in the PAGE_CONTENT_SIZE bytes of a page
+  int GetMaxRecordCount();
 
 private:
   /**
@@ -4,6 +4,12 @@
  * Wrapper around actual data page in main memory and also contains bookkeeping
  * information used by buffer pool manager like pin_count/dirty_flag/page_id.
  * Use page as a basic unit within the database system
+ * The page content lives in a frame of the buffer pool's aligned memory
+ * arena, set up by buffer pool manager, so it can be read and written with
+ * direct I/O. Over a read-only database it points into the memory mapped db
+ * file instead and must not be written.
+ * The last PAGE_CHECKSUM_SIZE bytes of a page hold the checksum stamped by
+ * disk manager, page layouts only use the first PAGE_CONTENT_SIZE bytes.
  */
 
 #pragma once
@@ -20,7 +26,7 @@ class Page {
   friend class BufferPoolManager;
 
 public:
-  Page() { ResetMemory(); }
+  Page() {}
   ~Page(){};
   // get actual data page content
   inline char *GetData() { return data_; }
@@ -44,13 +50,15 @@ private:
       page_id_ = INVALID_PAGE_ID;
       pin_count_ = 0;
       is_dirty_ = false;
+      is_io_ = false;
       ResetMemory();
   }
   // members
-  char data_[PAGE_SIZE]; // actual data
+  char *data_ = nullptr; // actual data, a frame of the buffer pool
   page_id_t page_id_ = INVALID_PAGE_ID;
   int pin_count_ = 0;
   bool is_dirty_ = false;
+  bool is_io_ = false; // content is being read from disk
   RWMutex rwlatch_;
 };
 
@@ -40,9 +40,13 @@ public:
   TableIterator operator++(int);
 
 private:
+  // keep SCAN_PREFETCH_WINDOW pages after page_id in flight
+  void ReadAhead(page_id_t page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  page_id_t prefetch_end_; // one past the last page asked to prefetch
 };
 
 } // namespace cmudb
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
+#include "index/extendible_hash_index.h"
 #include "logging/log_manager.h"
 #include "sqlite/sqlite3ext.h"
 #include "table/table_heap.h"
@@ -18,9 +19,26 @@ namespace cmudb {
 /* Helpers */
 Schema *ParseCreateStatement(const std::string &sql);
 
-IndexMetadata *ParseIndexStatement(std::string &sql,
-                                   const std::string &table_name,
-                                   Schema *schema);
+IndexMetadata *ParseIndexStatement(
+    std::string &sql, const std::string &table_name, Schema *schema,
+    IndexType index_type = IndexType::BPLUSTREE);
+
+IndexType ParseIndexType(std::string type);
+
+// key=value module arguments following the table schema
+struct ModuleOptions {
+  int page_size = 4096; // page size of a new db file
+  size_t pool_size = BUFFER_POOL_SIZE; // frames of the buffer pool
+  bool compression = false; // store pages of a new db file compressed
+};
+
+// split module arguments after the table schema into positional ones (index
+// schema, index type) and options
+std::vector<std::string> ParseModuleArgs(int argc, const char *const *argv,
+                                         ModuleOptions &options);
+
+// open the storage engine on first use, options of later tables are ignored
+void InitStorageEngine(sqlite3 *db, const ModuleOptions &options);
 
 Tuple ConstructTuple(Schema *schema, sqlite3_value **argv);
 
@@ -62,17 +80,18 @@ int VtabBegin(sqlite3_vtab *pVTab);
 // storage engine
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  StorageEngine(std::string db_file_name, bool read_only = false,
+                size_t pool_size = BUFFER_POOL_SIZE) {
     ENABLE_LOGGING = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, false, read_only);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ =
-        new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+        new BufferPoolManager(pool_size, disk_manager_, log_manager_);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,8 +101,12 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
-    delete disk_manager_;
+    // sqlite reconnects tables to a new storage engine after a failed
+    // statement, it must find their pages on disk
+    buffer_pool_manager_->FlushAllPages();
+    // background reader and writer of buffer pool still use disk manager
     delete buffer_pool_manager_;
+    delete disk_manager_;
     delete log_manager_;
     delete lock_manager_;
     delete transaction_manager_;
@@ -1,8 +1,11 @@
 /**
  * b_plus_tree.cpp
  */
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -16,15 +19,24 @@ INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                                 BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator,
-                                page_id_t root_page_id)
+                                page_id_t root_page_id, BPlusTreeMode mode)
     : index_name_(name), root_page_id_(root_page_id),
-      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator),
+      mode_(mode) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  root_latch_.RLock();
+  bool empty = root_page_id_ == INVALID_PAGE_ID;
+  root_latch_.RUnlock();
+  if (empty || mode_ == BPlusTreeMode::CRABBING)
+    return empty;
+  // B-link pages stay when their keys are removed
+  return const_cast<BPlusTree *>(this)->Begin().isEnd();
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -37,7 +49,17 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
-  return false;
+  Page *page = FindLeaf(key, false, Operation::READ);
+  if (page == nullptr)
+    return false;
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  ValueType value;
+  bool found = leaf->Lookup(key, value, comparator_);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  if (found)
+    result.push_back(value);
+  return found;
 }
 
 /*****************************************************************************
@@ -45,6 +67,8 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
  *****************************************************************************/
 /*
  * Insert constant key & value pair into b+ tree
+ * Most inserts do not split, so first try with only the leaf write latched.
+ * If the leaf is full, or the tree is empty, start over with write latches:
  * if current tree is empty, start new tree, update root page id and insert
  * entry, otherwise insert into leaf page.
  * @return: since we only support unique key, if user try to insert duplicate
@@ -53,40 +77,160 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                             Transaction *transaction) {
-  return false;
+  if (mode_ == BPlusTreeMode::B_LINK)
+    return InsertBLink(key, value);
+
+  Page *page = FindLeaf(key, false, Operation::INSERT);
+  if (page != nullptr) {
+    auto *leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    ValueType old_value;
+    bool exists = leaf->Lookup(key, old_value, comparator_);
+    bool safe = IsSafe(leaf, Operation::INSERT);
+    if (!exists && safe)
+      leaf->Insert(key, value, comparator_);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), !exists && safe);
+    if (exists || safe)
+      return !exists;
+  }
+
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr)
+    transaction = &local_transaction;
+  bool inserted = true;
+  try {
+    if (FindLeafExclusive(key, Operation::INSERT, transaction) == nullptr)
+      StartNewTree(key, value);
+    else
+      inserted = InsertIntoLeaf(key, value, transaction);
+  } catch (...) {
+    // out of frames before any page changed
+    ReleasePageSet(transaction, false);
+    throw;
+  }
+  ReleasePageSet(transaction, inserted);
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then update b+
  * tree's root page id and insert entry directly into leaf page.
+ * The header page is pinned first, so that the tree stays empty if the buffer
+ * pool is out of frames.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  FetchPage(HEADER_PAGE_ID);
+  page_id_t root_page_id;
+  Page *page;
+  try {
+    // the index claims an extent of its own
+    page = NewPage(root_page_id, INVALID_PAGE_ID);
+  } catch (...) {
+    buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+    throw;
+  }
+  auto *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  root->Init(root_page_id);
+  root->Insert(key, value, comparator_);
+  buffer_pool_manager_->UnpinPage(root_page_id, true);
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(true);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+}
 
 /*
  * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immdiately, otherwise insert entry. Remember to deal with split if necessary.
+ * The leaf is the last page latched by FindLeafExclusive(). Look through leaf
+ * page to see whether insert key exist or not. If exist, return immdiately,
+ * otherwise insert entry and split if the leaf overflows.
+ * The new pages of the splits are allocated before the leaf changes, so that
+ * running out of frames leaves the tree as it was.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
-  return false;
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(
+      transaction->GetPageSet()->back()->GetData());
+  ValueType old_value;
+  if (leaf->Lookup(key, old_value, comparator_))
+    return false;
+  std::vector<Page *> new_pages;
+  NewSplitPages(transaction, new_pages);
+  if (leaf->Insert(key, value, comparator_) > leaf->GetMaxSize()) {
+    Page *page = new_pages.back();
+    new_pages.pop_back();
+    B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf = Split(leaf, page);
+    InsertIntoParent(leaf, new_leaf->KeyAt(0), new_leaf, new_pages);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  // the header page, if the root split
+  for (Page *page : new_pages)
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return true;
+}
+
+/*
+ * Ask for the new pages an insert into the full leaf of the page set needs:
+ * one for every page that splits, which is every page of the set but a safe
+ * top one, and a new root if the root splits. The header page is pinned for
+ * the new root id then, ahead of the new root. Pages are pushed top down, so
+ * that splits from the leaf up pop them from the back. If the buffer pool is
+ * out of frames, the pages got so far are given back and an "out of memory"
+ * exception is thrown.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::NewSplitPages(Transaction *transaction,
+                                   std::vector<Page *> &new_pages) {
+  try {
+    for (Page *page : *transaction->GetPageSet()) {
+      if (page == nullptr)
+        continue;
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      if (IsSafe(node, Operation::INSERT))
+        continue;
+      page_id_t new_page_id;
+      if (node->IsRootPage()) {
+        new_pages.push_back(FetchPage(HEADER_PAGE_ID));
+        new_pages.push_back(NewPage(new_page_id, node->GetPageId()));
+      }
+      new_pages.push_back(NewPage(new_page_id, node->GetPageId()));
+    }
+  } catch (...) {
+    for (Page *page : new_pages) {
+      page_id_t page_id = page->GetPageId();
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      if (page_id != HEADER_PAGE_ID)
+        buffer_pool_manager_->DeletePage(page_id);
+    }
+    new_pages.clear();
+    throw;
+  }
 }
 
 /*
  * Split input page and return newly created page.
  * Using template N to represent either internal page or leaf page.
- * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * The caller asks for the new page, from the extent of node so that a scan
+ * reads leaves in ascending page order, then half of key & value pairs move
+ * from input page to the new one. It is not reachable before its parent is
+ * updated, which the caller has write latched, so it needs no latch of its
+ * own.
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) { return nullptr; }
+template <typename N> N *BPLUSTREE_TYPE::Split(N *node, Page *page) {
+  N *new_node = reinterpret_cast<N *>(page->GetData());
+  new_node->Init(page->GetPageId(), node->GetParentPageId());
+  // B-link mode does not keep the parent page ids of the children moved
+  node->MoveHalfTo(new_node, mode_ == BPlusTreeMode::B_LINK
+                                 ? nullptr
+                                 : buffer_pool_manager_);
+  return new_node;
+}
 
 /*
  * Insert key & value pair into internal page after split
@@ -96,12 +240,48 @@ template <typename N> N *BPLUSTREE_TYPE::Split(N *node) { return nullptr; }
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
  * recursively if necessary.
+ * The parent is write latched already, old_node was not safe. For the same
+ * reason a new root is only made while holding the root latch. New pages,
+ * for splits and the new root, are popped from the back of new_pages.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
                                       const KeyType &key,
                                       BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      std::vector<Page *> &new_pages) {
+  if (old_node->IsRootPage()) {
+    Page *page = new_pages.back();
+    new_pages.pop_back();
+    page_id_t root_page_id = page->GetPageId();
+    auto *root = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+        page->GetData());
+    root->Init(root_page_id);
+    root->SetLevel(GetLevel(old_node) + 1);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId();
+    return;
+  }
+  // the parent is in the page set, pinned already
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto *parent =
+      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>
+                           *>(FetchPage(parent_page_id)->GetData());
+  new_node->SetParentPageId(parent_page_id);
+  if (parent->InsertNodeAfter(old_node->GetPageId(), key,
+                              new_node->GetPageId()) > parent->GetMaxSize()) {
+    Page *page = new_pages.back();
+    new_pages.pop_back();
+    auto *new_parent = Split(parent, page);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, new_pages);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -112,21 +292,99 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * Like Insert(), first try with only the leaf write latched, and start over
+ * with write latches if the leaf would underflow.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  Page *page = FindLeaf(key, false, Operation::DELETE);
+  if (page == nullptr)
+    return;
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  ValueType value;
+  bool exists = leaf->Lookup(key, value, comparator_);
+  // B-link pages are not merged, any leaf is safe
+  bool safe =
+      mode_ == BPlusTreeMode::B_LINK || IsSafe(leaf, Operation::DELETE);
+  if (exists && safe)
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), exists && safe);
+  if (!exists || safe)
+    return;
+
+  Transaction local_transaction(INVALID_TXN_ID);
+  if (transaction == nullptr)
+    transaction = &local_transaction;
+  try {
+    page = FindLeafExclusive(key, Operation::DELETE, transaction);
+    if (page != nullptr) {
+      leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      if (leaf->RemoveAndDeleteRecord(key, comparator_) < leaf->GetMinSize())
+        CoalesceOrRedistribute(leaf, transaction);
+    }
+  } catch (...) {
+    // out of frames, pages changed so far are left underfull but consistent
+    ReleasePageSet(transaction, true);
+    throw;
+  }
+  ReleasePageSet(transaction, true);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
  * Using template N to represent either internal page or leaf page.
+ * The sibling is write latched and added to the page set; node and its
+ * parent are latched already. Pages merged away are added to the deleted page
+ * set, to be deleted once they are unlatched.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+  if (node->IsRootPage()) {
+    if (!AdjustRoot(node))
+      return false;
+    transaction->AddIntoDeletedPageSet(node->GetPageId());
+    return true;
+  }
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto *parent =
+      reinterpret_cast<BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>
+                           *>(FetchPage(parent_page_id)->GetData());
+  // the left sibling, or the right one of a first child
+  int index = parent->ValueIndex(node->GetPageId());
+  Page *sibling_page = FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  if (index != 0 && node->IsLeafPage()) {
+    // scans hold a leaf while latching the next one, latch left to right.
+    // node stays unreachable but by scans, its parent is latched
+    Page *node_page = GetLatchedPage(node->GetPageId(), transaction);
+    node_page->WUnlatch();
+    sibling_page->WLatch();
+    node_page->WLatch();
+  } else {
+    sibling_page->WLatch();
+  }
+  transaction->AddIntoPageSet(sibling_page);
+  N *sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  bool node_deleted = false;
+  if (sibling->GetSize() + node->GetSize() <= node->GetMaxSize()) {
+    // always merge the right page into the left one
+    if (index == 0) {
+      N *right = sibling;
+      Coalesce(node, right, parent, 1, transaction);
+    } else {
+      Coalesce(sibling, node, parent, index, transaction);
+      node_deleted = true;
+    }
+  } else {
+    Redistribute(sibling, node, index);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  return node_deleted;
 }
 
 /*
@@ -147,6 +405,11 @@ bool BPLUSTREE_TYPE::Coalesce(
     N *&neighbor_node, N *&node,
     BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
     int index, Transaction *transaction) {
+  node->MoveAllTo(neighbor_node, index, buffer_pool_manager_);
+  transaction->AddIntoDeletedPageSet(node->GetPageId());
+  parent->Remove(index);
+  if (parent->GetSize() < parent->GetMinSize())
+    return CoalesceOrRedistribute(parent, transaction);
   return false;
 }
 
@@ -161,7 +424,12 @@ bool BPLUSTREE_TYPE::Coalesce(
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  if (index == 0)
+    neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
+  else
+    neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,7 +442,25 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
-  return false;
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0)
+      return false;
+    root_page_id_ = INVALID_PAGE_ID;
+  } else {
+    if (old_root_node->GetSize() > 1)
+      return false;
+    auto *old_root = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+        old_root_node);
+    // the only child is latched, it has just been merged into or redistributed
+    root_page_id_ = old_root->RemoveAndReturnOnlyChild();
+    Page *page = FetchPage(root_page_id_);
+    reinterpret_cast<BPlusTreePage *>(page->GetData())
+        ->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  }
+  UpdateRootPageId();
+  return true;
 }
 
 /*****************************************************************************
@@ -186,7 +472,13 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  KeyType key{};
+  Page *page = FindLeaf(key, true, Operation::READ);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -195,7 +487,12 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  return INDEXITERATOR_TYPE();
+  Page *page = FindLeaf(key, false, Operation::READ);
+  if (page == nullptr)
+    return INDEXITERATOR_TYPE();
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page,
+                            leaf->KeyIndex(key, comparator_));
 }
 
 /*****************************************************************************
@@ -208,9 +505,401 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                          bool leftMost) {
+  Page *page = FindLeaf(key, leftMost, Operation::READ);
+  if (page == nullptr)
+    return nullptr;
+  page->RUnlatch();
+  return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+}
+
+/*
+ * Readers crab: latch the child, then release the parent. The type of a page
+ * never changes while it is in the tree, so whether the child is a leaf, and
+ * must be write latched for op, is known before latching it. A root leaf is
+ * latched under the root latch, it stays the root meanwhile.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeaf(const KeyType &key, bool left_most,
+                               Operation op) {
+  if (mode_ == BPlusTreeMode::B_LINK)
+    return FindPageBLink(key, left_most, 0, op != Operation::READ, nullptr);
+
+  root_latch_.RLock();
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page;
+  try {
+    page = FetchPage(root_page_id_);
+  } catch (...) {
+    root_latch_.RUnlock();
+    throw;
+  }
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  if (node->IsLeafPage() && op != Operation::READ)
+    page->WLatch();
+  else
+    page->RLatch();
+  root_latch_.RUnlock();
+
+  while (!node->IsLeafPage()) {
+    auto *internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    page_id_t child_page_id = left_most ? internal->ValueAt(0)
+                                        : internal->Lookup(key, comparator_);
+    Page *child_page;
+    try {
+      child_page = FetchPage(child_page_id);
+    } catch (...) {
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw;
+    }
+    node = reinterpret_cast<BPlusTreePage *>(child_page->GetData());
+    if (node->IsLeafPage() && op != Operation::READ)
+      child_page->WLatch();
+    else
+      child_page->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page = child_page;
+  }
+  return page;
+}
+
+/*
+ * Writers that may split or merge crab with write latches, from the root
+ * latch down. Once a page is safe nothing above it changes, and everything
+ * latched before it is released.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafExclusive(const KeyType &key, Operation op,
+                                        Transaction *transaction) {
+  root_latch_.WLock();
+  transaction->AddIntoPageSet(nullptr);
+  if (root_page_id_ == INVALID_PAGE_ID)
+    return nullptr;
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = FetchPage(page_id);
+    page->WLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op))
+      ReleasePageSet(transaction, false);
+    transaction->AddIntoPageSet(page);
+    if (node->IsLeafPage())
+      return page;
+    page_id = reinterpret_cast<
+                  BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+                  node)
+                  ->Lookup(key, comparator_);
+  }
+}
+
+/*
+ * An insert into a safe page does not split it, a delete from a safe page
+ * does not make it underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op) {
+  if (op == Operation::INSERT)
+    return node->GetSize() < node->GetMaxSize();
+  if (op == Operation::DELETE)
+    return node->GetSize() > node->GetMinSize();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  for (Page *page : *page_set) {
+    if (page == nullptr) {
+      root_latch_.WUnlock();
+    } else {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+    }
+  }
+  page_set->clear();
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_page_set)
+    buffer_pool_manager_->DeletePage(page_id);
+  deleted_page_set->clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::GetLatchedPage(page_id_t page_id,
+                                     Transaction *transaction) {
+  for (Page *page : *transaction->GetPageSet()) {
+    if (page != nullptr && page->GetPageId() == page_id)
+      return page;
+  }
   return nullptr;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::GetLevel(BPlusTreePage *node) {
+  if (node->IsLeafPage())
+    return 0;
+  return reinterpret_cast<
+             BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node)
+      ->GetLevel();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t BPLUSTREE_TYPE::MoveRight(BPlusTreePage *node, const KeyType &key) {
+  page_id_t next_page_id;
+  KeyType high_key;
+  if (node->IsLeafPage()) {
+    auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+    next_page_id = leaf->GetNextPageId();
+    high_key = leaf->GetHighKey();
+  } else {
+    auto *internal = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+    next_page_id = internal->GetNextPageId();
+    high_key = internal->GetHighKey();
+  }
+  if (next_page_id == INVALID_PAGE_ID || comparator_(key, high_key) < 0)
+    return INVALID_PAGE_ID;
+  return next_page_id;
+}
+
+/*****************************************************************************
+ * B-LINK MODE
+ *****************************************************************************/
+/*
+ * A page may have split since the descent read its parent, then key is to the
+ * right. Pages are never freed, so the latch of a page is released before the
+ * next one is taken. The level of a page never changes, it is known before
+ * the page is latched. The left most page of a level stays the left most one.
+ * Return nullptr if the tree is empty or lower than level.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindPageBLink(const KeyType &key, bool left_most,
+                                    int level, bool exclusive,
+                                    std::vector<page_id_t> *stack) {
+  root_latch_.RLock();
+  page_id_t page_id = root_page_id_;
+  root_latch_.RUnlock();
+  if (page_id == INVALID_PAGE_ID)
+    return nullptr;
+  while (true) {
+    Page *page = FetchPage(page_id);
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (GetLevel(node) < level) {
+      // only the root can be below level, the tree is not that high yet
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return nullptr;
+    }
+    bool exclusive_latch = exclusive && GetLevel(node) == level;
+    if (exclusive_latch)
+      page->WLatch();
+    else
+      page->RLatch();
+    page_id_t next_page_id =
+        left_most ? INVALID_PAGE_ID : MoveRight(node, key);
+    if (next_page_id == INVALID_PAGE_ID) {
+      if (GetLevel(node) == level)
+        return page;
+      if (stack != nullptr)
+        stack->push_back(page_id);
+      auto *internal = reinterpret_cast<
+          BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+      next_page_id = left_most ? internal->ValueAt(0)
+                               : internal->Lookup(key, comparator_);
+    }
+    if (exclusive_latch)
+      page->WUnlatch();
+    else
+      page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+/*
+ * Insert into the leaf of key, holding only its latch. A full leaf is split
+ * right away: the new right sibling gets the upper half of the leaf and is
+ * linked in before the leaf is released.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertBLink(const KeyType &key, const ValueType &value) {
+  std::vector<page_id_t> stack;
+  Page *page = FindPageBLink(key, false, 0, true, &stack);
+  while (page == nullptr) {
+    root_latch_.WLock();
+    bool empty = root_page_id_ == INVALID_PAGE_ID;
+    try {
+      if (empty)
+        StartNewTree(key, value);
+    } catch (...) {
+      root_latch_.WUnlock();
+      throw;
+    }
+    root_latch_.WUnlock();
+    if (empty)
+      return true;
+    page = FindPageBLink(key, false, 0, true, &stack);
+  }
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  ValueType old_value;
+  if (leaf->Lookup(key, old_value, comparator_)) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+    return false;
+  }
+  if (IsSafe(leaf, Operation::INSERT)) {
+    leaf->Insert(key, value, comparator_);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), true);
+    return true;
+  }
+  // get the page of the split before the leaf changes
+  page_id_t new_page_id;
+  Page *new_page;
+  try {
+    new_page = NewPage(new_page_id, leaf->GetPageId());
+  } catch (...) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+    throw;
+  }
+  leaf->Insert(key, value, comparator_);
+  B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf = Split(leaf, new_page);
+  KeyType separator = new_leaf->KeyAt(0);
+  page_id_t left_page_id = leaf->GetPageId();
+  page_id_t right_page_id = new_leaf->GetPageId();
+  buffer_pool_manager_->UnpinPage(right_page_id, true);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(left_page_id, true);
+  InsertIntoParentBLink(stack, left_page_id, 0, separator, right_page_id);
+  return true;
+}
+
+/*
+ * The parent is the last page of stack, or one to its right if it split
+ * meanwhile. Separators are inserted in key order: if the split page has no
+ * entry in the parent yet (its own split is still on the way up), it is the
+ * left sibling of the new page, so the new entry lands right after the entry
+ * that leads to both.
+ * A split of the root makes a new root under the root latch. If someone did
+ * already, the tree has grown and the parent is found from the new root.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::InsertIntoParentBLink(std::vector<page_id_t> &stack,
+                                           page_id_t left_page_id, int level,
+                                           const KeyType &key,
+                                           page_id_t right_page_id) {
+  KeyType separator = key;
+  while (true) {
+    if (stack.empty()) {
+      root_latch_.WLock();
+      if (root_page_id_ == left_page_id) {
+        // the header page is pinned first for the new root id. Out of
+        // frames, the tree keeps its root and the split is reached by links
+        page_id_t root_page_id;
+        Page *page;
+        try {
+          FetchPage(HEADER_PAGE_ID);
+        } catch (...) {
+          root_latch_.WUnlock();
+          throw;
+        }
+        try {
+          page = NewPage(root_page_id, left_page_id);
+        } catch (...) {
+          buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+          root_latch_.WUnlock();
+          throw;
+        }
+        auto *root = reinterpret_cast<
+            BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+            page->GetData());
+        root->Init(root_page_id);
+        root->SetLevel(level + 1);
+        root->PopulateNewRoot(left_page_id, separator, right_page_id);
+        buffer_pool_manager_->UnpinPage(root_page_id, true);
+        root_page_id_ = root_page_id;
+        UpdateRootPageId();
+        buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+        root_latch_.WUnlock();
+        return;
+      }
+      root_latch_.WUnlock();
+      Page *page = FindPageBLink(separator, false, level + 1, false, &stack);
+      if (page == nullptr) {
+        // the root is left of left page, its split has no new root yet
+        std::this_thread::yield();
+        continue;
+      }
+      stack.push_back(page->GetPageId());
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+
+    Page *page = FetchPage(stack.back());
+    stack.pop_back();
+    page->WLatch();
+    auto *parent = reinterpret_cast<
+        BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+        page->GetData());
+    page_id_t next_page_id;
+    while ((next_page_id = MoveRight(parent, separator)) != INVALID_PAGE_ID) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = FetchPage(next_page_id);
+      page->WLatch();
+      parent = reinterpret_cast<
+          BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(
+          page->GetData());
+    }
+    if (IsSafe(parent, Operation::INSERT)) {
+      parent->Insert(separator, right_page_id, comparator_);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+      return;
+    }
+    // get the page of the split before the parent changes. Out of frames,
+    // the separator is left out, the right page is reached by links
+    page_id_t new_page_id;
+    Page *new_page;
+    try {
+      new_page = NewPage(new_page_id, parent->GetPageId());
+    } catch (...) {
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      throw;
+    }
+    parent->Insert(separator, right_page_id, comparator_);
+    auto *new_parent = Split(parent, new_page);
+    separator = new_parent->KeyAt(0);
+    left_page_id = parent->GetPageId();
+    right_page_id = new_parent->GetPageId();
+    buffer_pool_manager_->UnpinPage(right_page_id, true);
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(left_page_id, true);
+    level++;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::NewPage(page_id_t &page_id, page_id_t near_page_id) {
+  Page *page = buffer_pool_manager_->NewExtentPage(page_id, near_page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
@@ -221,14 +910,15 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(
-      buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record)
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  else
+  HeaderPage *header_page = static_cast<HeaderPage *>(FetchPage(HEADER_PAGE_ID));
+  // header page is shared by all indexes
+  header_page->WLatch();
+  // create a new record<index_name + root_page_id> in header_page, a tree
+  // that became empty and grows again has one already
+  if (!insert_record || !header_page->InsertRecord(index_name_, root_page_id_))
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
+  header_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
@@ -237,7 +927,36 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
  * print out whole b+tree sturcture, rank by rank
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::string BPLUSTREE_TYPE::ToString(bool verbose) { return "Empty tree"; }
+std::string BPLUSTREE_TYPE::ToString(bool verbose) {
+  if (IsEmpty())
+    return "Empty tree";
+  std::ostringstream os;
+  std::queue<BPlusTreePage *> queue;
+  queue.push(reinterpret_cast<BPlusTreePage *>(
+      FetchPage(root_page_id_)->GetData()));
+  while (!queue.empty()) {
+    // one rank per line
+    size_t rank_size = queue.size();
+    for (size_t i = 0; i < rank_size; i++) {
+      BPlusTreePage *node = queue.front();
+      queue.pop();
+      if (i > 0)
+        os << " | ";
+      if (node->IsLeafPage()) {
+        os << reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(
+            verbose);
+      } else {
+        auto *internal = reinterpret_cast<
+            BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *>(node);
+        os << internal->ToString(verbose);
+        internal->QueueUpChildren(&queue, buffer_pool_manager_);
+      }
+      buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    }
+    os << '\n';
+  }
+  return os.str();
+}
 
 /*
  * This method is used for test only
@@ -14,7 +14,10 @@ BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata,
                                      page_id_t root_page_id)
     : Index(metadata), comparator_(metadata->GetKeySchema()),
       container_(metadata->GetName(), buffer_pool_manager, comparator_,
-                 root_page_id) {}
+                 root_page_id,
+                 metadata->GetIndexType() == IndexType::BLINKTREE
+                     ? BPlusTreeMode::B_LINK
+                     : BPlusTreeMode::CRABBING) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
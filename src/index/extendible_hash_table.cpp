@@ -0,0 +1,512 @@
+/**
+ * extendible_hash_table.cpp
+ */
+
+#include <cassert>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name,
+                                     BufferPoolManager *buffer_pool_manager,
+                                     const KeyComparator &comparator,
+                                     page_id_t directory_page_id)
+    : index_name_(name), directory_page_id_(directory_page_id),
+      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+/*
+ * Return the only value that associated with input key
+ * This method is used for point query
+ * @return : true means key exists
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::GetValue(const KeyType &key,
+                               std::vector<ValueType> &result,
+                               Transaction *transaction) {
+  table_latch_.RLock();
+  bool found = false;
+  ValueType value;
+  try {
+    if (directory_page_id_ != INVALID_PAGE_ID) {
+      // the directory does not change while the table is latched
+      HashTableDirectoryPage *directory =
+          GetDirectory(FetchPage(directory_page_id_));
+      page_id_t bucket_page_id = directory->GetBucketPageId(
+          Hash(key) & directory->GetGlobalDepthMask());
+      buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+      Page *bucket_page = FetchPage(bucket_page_id);
+      bucket_page->RLatch();
+      try {
+        found = ChainLookup(GetBucket(bucket_page), key, value);
+      } catch (...) {
+        bucket_page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+        throw;
+      }
+      bucket_page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+    }
+  } catch (...) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  if (found)
+    result.push_back(value);
+  return found;
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert into the bucket of key if it has room, or if it can not split and
+ * grows an overflow page instead, otherwise start over with the table latched
+ * exclusively and split
+ * @return: since we only support unique key, if user try to insert duplicate
+ * keys return false, otherwise return true.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::Insert(const KeyType &key, const ValueType &value,
+                             Transaction *transaction) {
+  table_latch_.RLock();
+  bool done = false;
+  bool inserted = false;
+  try {
+    if (directory_page_id_ != INVALID_PAGE_ID) {
+      HashTableDirectoryPage *directory =
+          GetDirectory(FetchPage(directory_page_id_));
+      uint32_t bucket_idx = Hash(key) & directory->GetGlobalDepthMask();
+      page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+      bool overflow =
+          directory->GetLocalDepth(bucket_idx) == DIRECTORY_MAX_DEPTH;
+      buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+      Page *bucket_page = FetchPage(bucket_page_id);
+      bucket_page->WLatch();
+      HASH_TABLE_BUCKET_TYPE *bucket = GetBucket(bucket_page);
+      try {
+        ValueType old_value;
+        if (ChainLookup(bucket, key, old_value))
+          done = true;
+        else
+          done = inserted = ChainInsert(bucket, key, value, overflow);
+      } catch (...) {
+        bucket_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+        throw;
+      }
+      bucket_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+    }
+  } catch (...) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  if (done)
+    return inserted;
+
+  table_latch_.WLock();
+  try {
+    inserted = SplitInsert(key, value);
+  } catch (...) {
+    table_latch_.WUnlock();
+    throw;
+  }
+  table_latch_.WUnlock();
+  return inserted;
+}
+
+/*
+ * Create the directory with a single bucket and record the directory page id
+ * in header page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::StartNewTable() {
+  page_id_t bucket_page_id;
+  Page *bucket_page = buffer_pool_manager_->NewPage(bucket_page_id);
+  if (bucket_page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  GetBucket(bucket_page)->Init();
+  page_id_t directory_page_id;
+  Page *directory_page = buffer_pool_manager_->NewPage(directory_page_id);
+  if (directory_page == nullptr) {
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  GetDirectory(directory_page)->Init(directory_page_id, bucket_page_id);
+  buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+  buffer_pool_manager_->UnpinPage(directory_page_id, true);
+  directory_page_id_ = directory_page_id;
+
+  auto header_page = static_cast<HeaderPage *>(FetchPage(HEADER_PAGE_ID));
+  header_page->InsertRecord(index_name_, directory_page_id_);
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+/*
+ * Split the bucket of key until it has room: pairs whose hash has the bit
+ * just above the local depth set move to a new split image bucket, doubling
+ * the directory first if the bucket already uses all of its bits. A bucket
+ * at DIRECTORY_MAX_DEPTH can not split, it grows an overflow page instead.
+ * Pages are unpinned before an exception leaves.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::SplitInsert(const KeyType &key, const ValueType &value) {
+  if (directory_page_id_ == INVALID_PAGE_ID)
+    StartNewTable();
+  HashTableDirectoryPage *directory =
+      GetDirectory(FetchPage(directory_page_id_));
+  bool directory_dirty = false;
+  bool inserted = false;
+  page_id_t bucket_page_id = INVALID_PAGE_ID;
+  try {
+    while (true) {
+      uint32_t bucket_idx = Hash(key) & directory->GetGlobalDepthMask();
+      page_id_t page_id = directory->GetBucketPageId(bucket_idx);
+      HASH_TABLE_BUCKET_TYPE *bucket = GetBucket(FetchPage(page_id));
+      bucket_page_id = page_id;
+      uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+      ValueType old_value;
+      if (ChainLookup(bucket, key, old_value))
+        break;
+      if (ChainInsert(bucket, key, value,
+                      local_depth == DIRECTORY_MAX_DEPTH)) {
+        inserted = true;
+        break;
+      }
+      // only buckets at the maximum depth have overflow pages
+      assert(bucket->GetNextPageId() == INVALID_PAGE_ID);
+      if (local_depth == directory->GetGlobalDepth()) {
+        directory->IncrGlobalDepth();
+        directory_dirty = true;
+      }
+
+      page_id_t image_page_id;
+      Page *image_page = buffer_pool_manager_->NewPage(image_page_id);
+      if (image_page == nullptr)
+        throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+      HASH_TABLE_BUCKET_TYPE *image = GetBucket(image_page);
+      image->Init();
+      uint32_t high_bit = 1u << local_depth;
+      for (uint32_t i = bucket_idx & (high_bit - 1); i < directory->Size();
+           i += high_bit) {
+        directory->SetLocalDepth(i, local_depth + 1);
+        if (i & high_bit)
+          directory->SetBucketPageId(i, image_page_id);
+      }
+      // pairs after i are already checked when RemoveAt moves the last one
+      for (int i = bucket->GetSize() - 1; i >= 0; i--) {
+        if (Hash(bucket->KeyAt(i)) & high_bit) {
+          image->Insert(bucket->KeyAt(i), bucket->ValueAt(i), comparator_);
+          bucket->RemoveAt(i);
+        }
+      }
+      directory_dirty = true;
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      bucket_page_id = INVALID_PAGE_ID;
+      buffer_pool_manager_->UnpinPage(image_page_id, true);
+    }
+  } catch (...) {
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+    throw;
+  }
+  buffer_pool_manager_->UnpinPage(bucket_page_id, inserted);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+  return inserted;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Delete key & value pair associated with input key. A bucket left empty is
+ * merged with its split image under the exclusive table latch.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  table_latch_.RLock();
+  bool merge = false;
+  try {
+    if (directory_page_id_ != INVALID_PAGE_ID) {
+      HashTableDirectoryPage *directory =
+          GetDirectory(FetchPage(directory_page_id_));
+      uint32_t bucket_idx = Hash(key) & directory->GetGlobalDepthMask();
+      page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+      uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+      buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+      Page *bucket_page = FetchPage(bucket_page_id);
+      bucket_page->WLatch();
+      HASH_TABLE_BUCKET_TYPE *bucket = GetBucket(bucket_page);
+      bool removed;
+      try {
+        removed = ChainRemove(bucket, key);
+      } catch (...) {
+        bucket_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+        throw;
+      }
+      merge = removed && bucket->IsEmpty() &&
+              bucket->GetNextPageId() == INVALID_PAGE_ID && local_depth > 0;
+      bucket_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(bucket_page_id, removed);
+    }
+  } catch (...) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+
+  if (merge) {
+    table_latch_.WLock();
+    try {
+      Merge(key);
+    } catch (...) {
+      table_latch_.WUnlock();
+      throw;
+    }
+    table_latch_.WUnlock();
+  }
+}
+
+/*
+ * Fold the bucket of key into its split image while both have the same local
+ * depth, no overflow page and their pairs fit in one page, then halve the
+ * directory while no bucket needs all of its bits
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_TYPE::Merge(const KeyType &key) {
+  HashTableDirectoryPage *directory =
+      GetDirectory(FetchPage(directory_page_id_));
+  bool directory_dirty = false;
+  try {
+    while (true) {
+      uint32_t bucket_idx = Hash(key) & directory->GetGlobalDepthMask();
+      uint32_t local_depth = directory->GetLocalDepth(bucket_idx);
+      if (local_depth == 0)
+        break;
+      uint32_t image_idx = directory->GetSplitImageIndex(bucket_idx);
+      if (directory->GetLocalDepth(image_idx) != local_depth)
+        break;
+      page_id_t bucket_page_id = directory->GetBucketPageId(bucket_idx);
+      page_id_t image_page_id = directory->GetBucketPageId(image_idx);
+      HASH_TABLE_BUCKET_TYPE *bucket = GetBucket(FetchPage(bucket_page_id));
+      Page *image_page = buffer_pool_manager_->FetchPage(image_page_id);
+      if (image_page == nullptr) {
+        buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+        throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+      }
+      HASH_TABLE_BUCKET_TYPE *image = GetBucket(image_page);
+      if (bucket->GetNextPageId() != INVALID_PAGE_ID ||
+          image->GetNextPageId() != INVALID_PAGE_ID ||
+          bucket->GetSize() + image->GetSize() >
+              HASH_TABLE_BUCKET_TYPE::GetMaxSize()) {
+        buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+        buffer_pool_manager_->UnpinPage(image_page_id, false);
+        break;
+      }
+      for (int i = 0; i < bucket->GetSize(); i++)
+        image->Insert(bucket->KeyAt(i), bucket->ValueAt(i), comparator_);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+      buffer_pool_manager_->UnpinPage(image_page_id, true);
+      buffer_pool_manager_->DeletePage(bucket_page_id);
+
+      uint32_t low_bits = 1u << (local_depth - 1);
+      for (uint32_t i = bucket_idx & (low_bits - 1); i < directory->Size();
+           i += low_bits) {
+        directory->SetBucketPageId(i, image_page_id);
+        directory->SetLocalDepth(i, local_depth - 1);
+      }
+      directory_dirty = true;
+    }
+  } catch (...) {
+    buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+    throw;
+  }
+  while (directory->CanShrink()) {
+    directory->DecrGlobalDepth();
+    directory_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+}
+
+/*****************************************************************************
+ * OVERFLOW CHAINS
+ *****************************************************************************/
+/*
+ * The overflow pages of a bucket are only reached through the bucket page,
+ * whose latch covers them. The walks below pin one overflow page at a time
+ * and unpin it before they throw.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainLookup(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const KeyType &key, ValueType &value) {
+  if (bucket->Lookup(key, value, comparator_))
+    return true;
+  page_id_t next_page_id = bucket->GetNextPageId();
+  while (next_page_id != INVALID_PAGE_ID) {
+    page_id_t page_id = next_page_id;
+    HASH_TABLE_BUCKET_TYPE *overflow = GetBucket(FetchPage(page_id));
+    bool found = overflow->Lookup(key, value, comparator_);
+    next_page_id = overflow->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (found)
+      return true;
+  }
+  return false;
+}
+
+/*
+ * Insert a pair known to be absent into the first page of the chain with
+ * room. If there is none, link a new overflow page at the end if overflow is
+ * set, otherwise return false.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainInsert(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const KeyType &key, const ValueType &value,
+                                  bool overflow) {
+  if (bucket->Insert(key, value, comparator_))
+    return true;
+  HASH_TABLE_BUCKET_TYPE *last = bucket;
+  // INVALID_PAGE_ID while last is the bucket itself, unpinning it is a no-op
+  page_id_t last_page_id = INVALID_PAGE_ID;
+  while (last->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t page_id = last->GetNextPageId();
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    last = GetBucket(page);
+    last_page_id = page_id;
+    if (last->Insert(key, value, comparator_)) {
+      buffer_pool_manager_->UnpinPage(last_page_id, true);
+      return true;
+    }
+  }
+  if (!overflow) {
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    return false;
+  }
+  page_id_t overflow_page_id;
+  Page *page = buffer_pool_manager_->NewPage(overflow_page_id);
+  if (page == nullptr) {
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  }
+  HASH_TABLE_BUCKET_TYPE *overflow_bucket = GetBucket(page);
+  overflow_bucket->Init();
+  overflow_bucket->Insert(key, value, comparator_);
+  last->SetNextPageId(overflow_page_id);
+  buffer_pool_manager_->UnpinPage(overflow_page_id, true);
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  return true;
+}
+
+/*
+ * Remove key from the chain, an overflow page left empty is unlinked and
+ * deleted
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_TYPE::ChainRemove(HASH_TABLE_BUCKET_TYPE *bucket,
+                                  const KeyType &key) {
+  if (bucket->Remove(key, comparator_))
+    return true;
+  HASH_TABLE_BUCKET_TYPE *prev = bucket;
+  // INVALID_PAGE_ID while prev is the bucket itself
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  while (prev->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t page_id = prev->GetNextPageId();
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      buffer_pool_manager_->UnpinPage(prev_page_id, false);
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    HASH_TABLE_BUCKET_TYPE *overflow = GetBucket(page);
+    if (overflow->Remove(key, comparator_)) {
+      bool unlink = overflow->IsEmpty();
+      if (unlink)
+        prev->SetNextPageId(overflow->GetNextPageId());
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      buffer_pool_manager_->UnpinPage(prev_page_id, unlink);
+      if (unlink)
+        buffer_pool_manager_->DeletePage(page_id);
+      return true;
+    }
+    buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    prev = overflow;
+    prev_page_id = page_id;
+  }
+  buffer_pool_manager_->UnpinPage(prev_page_id, false);
+  return false;
+}
+
+/*****************************************************************************
+ * UTILITIES AND DEBUG
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
+  table_latch_.RLock();
+  uint32_t global_depth = 0;
+  try {
+    if (directory_page_id_ != INVALID_PAGE_ID) {
+      global_depth =
+          GetDirectory(FetchPage(directory_page_id_))->GetGlobalDepth();
+      buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    }
+  } catch (...) {
+    table_latch_.RUnlock();
+    throw;
+  }
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+/*
+ * FNV-1a over the key bytes, keys are compared by content so equal keys hash
+ * alike
+ */
+INDEX_TEMPLATE_ARGUMENTS
+uint32_t HASH_TABLE_TYPE::Hash(const KeyType &key) const {
+  auto data = reinterpret_cast<const unsigned char *>(&key);
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < sizeof(KeyType); i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ull;
+  }
+  return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *HASH_TABLE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+HashTableDirectoryPage *HASH_TABLE_TYPE::GetDirectory(Page *page) {
+  return reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::GetBucket(Page *page) {
+  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+}
+
+template class ExtendibleHashTable<GenericKey<4>, RID, GenericComparator<4>>;
+template class ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>>;
+template class ExtendibleHashTable<GenericKey<16>, RID, GenericComparator<16>>;
+template class ExtendibleHashTable<GenericKey<32>, RID, GenericComparator<32>>;
+template class ExtendibleHashTable<GenericKey<64>, RID, GenericComparator<64>>;
+
+} // namespace cmudb
@@ -3,19 +3,109 @@
  */
 #include <cassert>
 
+#include "common/config.h"
+#include "common/exception.h"
 #include "index/index_iterator.h"
 
 namespace cmudb {
 
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator()
+    : buffer_pool_manager_(nullptr), page_(nullptr), leaf_(nullptr),
+      index_(0), prefetch_end_(INVALID_PAGE_ID) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager,
+                                  Page *page, int index)
+    : buffer_pool_manager_(buffer_pool_manager), page_(page),
+      leaf_(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())),
+      index_(index), prefetch_end_(INVALID_PAGE_ID) {
+  ReadAhead();
+  SkipExhaustedLeaves();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other)
+    : buffer_pool_manager_(other.buffer_pool_manager_), page_(other.page_),
+      leaf_(other.leaf_), index_(other.index_),
+      prefetch_end_(other.prefetch_end_) {
+  other.page_ = nullptr;
+  other.leaf_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::isEnd() { return leaf_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  assert(!isEnd());
+  return leaf_->GetItem(index_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(!isEnd());
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+/*
+ * Latch the next leaf before releasing the current one, it can not be merged
+ * away in between
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (leaf_ != nullptr && index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      Release();
+      return;
+    }
+    Page *next_page = buffer_pool_manager_->FetchPage(next_page_id);
+    if (next_page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    next_page->RLatch();
+    Release();
+    page_ = next_page;
+    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+    index_ = 0;
+    ReadAhead();
+  }
+}
+
 /*
- * NOTE: you can change the destructor/constructor method here
- * set your own input parameters
+ * Only the part of the window not asked for yet is requested; the window
+ * restarts when the next leaf is outside of it.
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() {}
+void INDEXITERATOR_TYPE::ReadAhead() {
+  page_id_t next_page_id = leaf_->GetNextPageId();
+  if (SCAN_PREFETCH_WINDOW == 0 || next_page_id == INVALID_PAGE_ID)
+    return;
+  page_id_t window_end =
+      next_page_id + static_cast<page_id_t>(SCAN_PREFETCH_WINDOW);
+  if (prefetch_end_ <= next_page_id || prefetch_end_ > window_end)
+    prefetch_end_ = next_page_id;
+  if (prefetch_end_ < window_end) {
+    buffer_pool_manager_->PrefetchPages(prefetch_end_,
+                                        window_end - prefetch_end_);
+    prefetch_end_ = window_end;
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {}
+void INDEXITERATOR_TYPE::Release() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  leaf_ = nullptr;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
@@ -0,0 +1,109 @@
+/**
+ * hash_table_bucket_page.cpp
+ */
+
+#include <cassert>
+
+#include "common/rid.h"
+#include "page/hash_table_bucket_page.h"
+
+namespace cmudb {
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::Init() {
+  size_ = 0;
+  lsn_ = INVALID_LSN;
+  next_page_id_ = INVALID_PAGE_ID;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_TYPE::GetMaxSize() {
+  return (PAGE_CONTENT_SIZE - sizeof(HashTableBucketPage)) / sizeof(MappingType);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int HASH_TABLE_BUCKET_TYPE::GetSize() const { return size_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::IsFull() const { return size_ >= GetMaxSize(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::IsEmpty() const { return size_ == 0; }
+
+INDEX_TEMPLATE_ARGUMENTS
+lsn_t HASH_TABLE_BUCKET_TYPE::GetLSN() const { return lsn_; }
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t HASH_TABLE_BUCKET_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType HASH_TABLE_BUCKET_TYPE::KeyAt(int index) const {
+  assert(index >= 0 && index < size_);
+  return array[index].first;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+ValueType HASH_TABLE_BUCKET_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < size_);
+  return array[index].second;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Lookup(const KeyType &key, ValueType &value,
+                                    const KeyComparator &comparator) const {
+  for (int i = 0; i < size_; i++) {
+    if (comparator(array[i].first, key) == 0) {
+      value = array[i].second;
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Insert(const KeyType &key, const ValueType &value,
+                                    const KeyComparator &comparator) {
+  ValueType old_value;
+  if (IsFull() || Lookup(key, old_value, comparator))
+    return false;
+  array[size_].first = key;
+  array[size_].second = value;
+  size_++;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool HASH_TABLE_BUCKET_TYPE::Remove(const KeyType &key,
+                                    const KeyComparator &comparator) {
+  for (int i = 0; i < size_; i++) {
+    if (comparator(array[i].first, key) == 0) {
+      RemoveAt(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void HASH_TABLE_BUCKET_TYPE::RemoveAt(int index) {
+  assert(index >= 0 && index < size_);
+  size_--;
+  array[index] = array[size_];
+}
+
+template class HashTableBucketPage<GenericKey<4>, RID, GenericComparator<4>>;
+template class HashTableBucketPage<GenericKey<8>, RID, GenericComparator<8>>;
+template class HashTableBucketPage<GenericKey<16>, RID, GenericComparator<16>>;
+template class HashTableBucketPage<GenericKey<32>, RID, GenericComparator<32>>;
+template class HashTableBucketPage<GenericKey<64>, RID, GenericComparator<64>>;
+} // namespace cmudb
@@ -0,0 +1,97 @@
+/**
+ * hash_table_directory_page.cpp
+ */
+
+#include <cassert>
+
+#include "page/hash_table_directory_page.h"
+
+namespace cmudb {
+
+void HashTableDirectoryPage::Init(page_id_t page_id, page_id_t bucket_page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  global_depth_ = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+  LocalDepths()[0] = 0;
+}
+
+page_id_t HashTableDirectoryPage::GetPageId() const { return page_id_; }
+
+lsn_t HashTableDirectoryPage::GetLSN() const { return lsn_; }
+
+void HashTableDirectoryPage::SetLSN(lsn_t lsn) { lsn_ = lsn; }
+
+uint32_t HashTableDirectoryPage::Size() const { return 1u << global_depth_; }
+
+uint32_t HashTableDirectoryPage::GetGlobalDepth() const {
+  return global_depth_;
+}
+
+uint32_t HashTableDirectoryPage::GetGlobalDepthMask() const {
+  return Size() - 1;
+}
+
+void HashTableDirectoryPage::IncrGlobalDepth() {
+  assert(global_depth_ < DIRECTORY_MAX_DEPTH);
+  uint32_t size = Size();
+  for (uint32_t i = 0; i < size; i++) {
+    bucket_page_ids_[size + i] = bucket_page_ids_[i];
+    LocalDepths()[size + i] = LocalDepths()[i];
+  }
+  global_depth_++;
+}
+
+void HashTableDirectoryPage::DecrGlobalDepth() {
+  assert(CanShrink());
+  global_depth_--;
+}
+
+bool HashTableDirectoryPage::CanShrink() const {
+  if (global_depth_ == 0)
+    return false;
+  for (uint32_t i = 0; i < Size(); i++) {
+    if (LocalDepths()[i] == global_depth_)
+      return false;
+  }
+  return true;
+}
+
+page_id_t HashTableDirectoryPage::GetBucketPageId(uint32_t bucket_idx) const {
+  assert(bucket_idx < Size());
+  return bucket_page_ids_[bucket_idx];
+}
+
+void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx,
+                                             page_id_t bucket_page_id) {
+  assert(bucket_idx < Size());
+  bucket_page_ids_[bucket_idx] = bucket_page_id;
+}
+
+uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) const {
+  assert(bucket_idx < Size());
+  return LocalDepths()[bucket_idx];
+}
+
+void HashTableDirectoryPage::SetLocalDepth(uint32_t bucket_idx,
+                                           uint32_t local_depth) {
+  assert(bucket_idx < Size() && local_depth <= global_depth_);
+  LocalDepths()[bucket_idx] = static_cast<uint8_t>(local_depth);
+}
+
+uint32_t HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) const {
+  uint32_t local_depth = GetLocalDepth(bucket_idx);
+  assert(local_depth > 0);
+  return bucket_idx ^ (1u << (local_depth - 1));
+}
+
+uint8_t *HashTableDirectoryPage::LocalDepths() {
+  return reinterpret_cast<uint8_t *>(bucket_page_ids_ + DIRECTORY_ARRAY_SIZE);
+}
+
+const uint8_t *HashTableDirectoryPage::LocalDepths() const {
+  return reinterpret_cast<const uint8_t *>(bucket_page_ids_ +
+                                           DIRECTORY_ARRAY_SIZE);
+}
+
+} // namespace cmudb
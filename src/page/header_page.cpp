@@ -21,6 +21,9 @@ bool HeaderPage::InsertRecord(const std::string &name,
   // check for duplicate name
   if (FindRecord(name) != -1)
     return false;
+  // check for space left in the page
+  if (record_num >= GetMaxRecordCount())
+    return false;
   // copy record content
   memcpy(GetData() + offset, name.c_str(), (name.length() + 1));
   memcpy((GetData() + offset + 32), &root_id, 4);
@@ -79,6 +82,8 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
 // record count
 int HeaderPage::GetRecordCount() { return *reinterpret_cast<int *>(GetData()); }
 
+int HeaderPage::GetMaxRecordCount() { return (PAGE_CONTENT_SIZE - 4) / 36; }
+
 void HeaderPage::SetRecordCount(int record_count) {
   memcpy(GetData(), &record_count, 4);
 }
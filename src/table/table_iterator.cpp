@@ -9,8 +9,10 @@
 namespace cmudb {
 
 TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn),
+      prefetch_end_(INVALID_PAGE_ID) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
+    ReadAhead(rid.GetPageId());
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
 };
@@ -49,6 +51,7 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->end()) {
+    ReadAhead(tuple_->rid_.GetPageId());
     table_heap_->GetTuple(tuple_->rid_, *tuple_, txn_);
   }
   // release until copy the tuple
@@ -63,4 +66,25 @@ TableIterator TableIterator::operator++(int) {
   return clone;
 }
 
+/*
+ * Table pages are linked in a list, but a heap grows by allocating one page
+ * after another, so read ahead by page id. Only the part of the window not
+ * asked for yet is requested; the window restarts when the scan jumps.
+ */
+void TableIterator::ReadAhead(page_id_t page_id) {
+  if (SCAN_PREFETCH_WINDOW == 0) {
+    return;
+  }
+  page_id_t window_end =
+      page_id + 1 + static_cast<page_id_t>(SCAN_PREFETCH_WINDOW);
+  if (prefetch_end_ <= page_id || prefetch_end_ > window_end) {
+    prefetch_end_ = page_id + 1;
+  }
+  if (prefetch_end_ < window_end) {
+    table_heap_->buffer_pool_manager_->PrefetchPages(
+        prefetch_end_, window_end - prefetch_end_);
+    prefetch_end_ = window_end;
+  }
+}
+
 } // namespace cmudb
@@ -2,8 +2,11 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <sys/stat.h>
 #include <vector>
 
@@ -17,94 +20,171 @@ namespace cmudb {
 
 SQLITE_EXTENSION_INIT1
 
+/*
+ * hand an exception thrown by the storage engine back to sqlite as the error
+ * message of the virtual table, exceptions must not unwind through sqlite
+ */
+static int VtabError(sqlite3_vtab *pVTab, const std::exception &e) {
+  sqlite3_free(pVTab->zErrMsg);
+  pVTab->zErrMsg = sqlite3_mprintf("%s", e.what());
+  return SQLITE_ERROR;
+}
+
 /* API implementation */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr) {
-  BufferPoolManager *buffer_pool_manager =
-      storage_engine_->buffer_pool_manager_;
-  LockManager *lock_manager = storage_engine_->lock_manager_;
-  LogManager *log_manager = storage_engine_->log_manager_;
-
-  // fetch header page from buffer pool
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
-
   // the first three parameter:(1) module name (2) database name (3)table name
   assert(argc >= 4);
-  // parse arg[3](string that defines table schema)
-  std::string schema_string(argv[3]);
-  schema_string = schema_string.substr(1, (schema_string.size() - 2));
-  Schema *schema = ParseCreateStatement(schema_string);
-
-  // parse arg[4](string that defines table index)
-  Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
-    index_string = index_string.substr(1, (index_string.size() - 2));
-    // create index object, allocate memory space
-    IndexMetadata *index_metadata =
-        ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    index = ConstructIndex(index_metadata, buffer_pool_manager);
-  }
-  // create table object, allocate memory space
-  VirtualTable *table = new VirtualTable(schema, buffer_pool_manager,
-                                         lock_manager, log_manager, index);
+  // errors must not unwind through sqlite, they fail the statement instead
+  try {
+    ModuleOptions options;
+    std::vector<std::string> args = ParseModuleArgs(argc, argv, options);
+    // parse optional index type, bplustree by default
+    IndexType index_type =
+        args.size() > 1 ? ParseIndexType(args[1]) : IndexType::BPLUSTREE;
+    // parse arg[3](string that defines table schema)
+    std::string schema_string(argv[3]);
+    schema_string = schema_string.substr(1, (schema_string.size() - 2));
+    std::unique_ptr<Schema> schema(ParseCreateStatement(schema_string));
+    // parse arg[4](string that defines table index)
+    IndexMetadata *index_metadata = nullptr;
+    if (!args.empty()) {
+      std::string index_string(args[0]);
+      index_string = index_string.substr(1, (index_string.size() - 2));
+      index_metadata = ParseIndexStatement(index_string, std::string(argv[2]),
+                                           schema.get(), index_type);
+    }
 
-  // insert table root page info into header page
-  header_page->InsertRecord(std::string(argv[2]), table->GetFirstPageId());
-  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+    InitStorageEngine(db, options);
+    if (storage_engine_->disk_manager_->IsReadOnly()) {
+      delete index_metadata;
+      return SQLITE_READONLY;
+    }
+    BufferPoolManager *buffer_pool_manager =
+        storage_engine_->buffer_pool_manager_;
+    LockManager *lock_manager = storage_engine_->lock_manager_;
+    LogManager *log_manager = storage_engine_->log_manager_;
+
+    // header page must have room for the records of table and index
+    std::string table_name(argv[2]);
+    HeaderPage *header_page = static_cast<HeaderPage *>(
+        buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+    page_id_t root_id;
+    bool exists = header_page->GetRootId(table_name, root_id);
+    int record_count = header_page->GetRecordCount() +
+                       (index_metadata != nullptr ? 2 : 1);
+    bool full = record_count > header_page->GetMaxRecordCount();
+    buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+    std::string error;
+    if (table_name.length() >= 32 ||
+        (index_metadata != nullptr && index_metadata->GetName().length() >= 32))
+      error = "table or index name of " + table_name + " is too long";
+    else if (exists)
+      error = "table " + table_name + " already exists";
+    else if (full)
+      error = "header page is full, can't create table " + table_name;
+    if (!error.empty()) {
+      delete index_metadata;
+      throw Exception(EXCEPTION_TYPE_CATALOG, error);
+    }
 
-  // register virtual table within sqlite system
-  schema_string = "CREATE TABLE X(" + schema_string + ");";
-  assert(sqlite3_declare_vtab(db, schema_string.c_str()) == SQLITE_OK);
+    // create index object, allocate memory space
+    Index *index = nullptr;
+    if (index_metadata != nullptr)
+      index = ConstructIndex(index_metadata, buffer_pool_manager);
+    // create table object, allocate memory space
+    VirtualTable *table =
+        new VirtualTable(schema.release(), buffer_pool_manager, lock_manager,
+                         log_manager, index);
+
+    // insert table root page info into header page
+    header_page = static_cast<HeaderPage *>(
+        buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+    bool inserted =
+        header_page->InsertRecord(table_name, table->GetFirstPageId());
+    buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, inserted);
+    if (!inserted) {
+      delete table;
+      throw Exception(EXCEPTION_TYPE_CATALOG,
+                      "can't record table " + table_name + " in header page");
+    }
 
-  *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
-  return SQLITE_OK;
+    // register virtual table within sqlite system
+    schema_string = "CREATE TABLE X(" + schema_string + ");";
+    assert(sqlite3_declare_vtab(db, schema_string.c_str()) == SQLITE_OK);
+
+    *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
+    return SQLITE_OK;
+  } catch (std::exception &e) {
+    *pzErr = sqlite3_mprintf("%s", e.what());
+    return SQLITE_ERROR;
+  }
 }
 
 int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                 sqlite3_vtab **ppVtab, char **pzErr) {
   assert(argc >= 4);
-  std::string schema_string(argv[3]);
-  // remove the very first and last character
-  schema_string = schema_string.substr(1, (schema_string.size() - 2));
-  // new virtual table object, allocate memory space
-  Schema *schema = ParseCreateStatement(schema_string);
-
-  BufferPoolManager *buffer_pool_manager =
-      storage_engine_->buffer_pool_manager_;
-  LockManager *lock_manager = storage_engine_->lock_manager_;
-  LogManager *log_manager = storage_engine_->log_manager_;
-
-  // Retrieve table root page info from header page
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
-  page_id_t table_root_id;
-  header_page->GetRootId(std::string(argv[2]), table_root_id);
-  // parse arg[4](string that defines table index)
-  Index *index = nullptr;
-  if (argc > 4) {
-    std::string index_string(argv[4]);
-    index_string = index_string.substr(1, (index_string.size() - 2));
+  // errors must not unwind through sqlite, they fail the statement instead
+  try {
+    std::string schema_string(argv[3]);
+    // remove the very first and last character
+    schema_string = schema_string.substr(1, (schema_string.size() - 2));
+    ModuleOptions options;
+    std::vector<std::string> args = ParseModuleArgs(argc, argv, options);
+    // parse optional index type, bplustree by default
+    IndexType index_type =
+        args.size() > 1 ? ParseIndexType(args[1]) : IndexType::BPLUSTREE;
+    // new virtual table object, allocate memory space
+    std::unique_ptr<Schema> schema(ParseCreateStatement(schema_string));
+    // parse arg[4](string that defines table index)
+    IndexMetadata *index_metadata = nullptr;
+    if (!args.empty()) {
+      std::string index_string(args[0]);
+      index_string = index_string.substr(1, (index_string.size() - 2));
+      index_metadata = ParseIndexStatement(index_string, std::string(argv[2]),
+                                           schema.get(), index_type);
+    }
+    InitStorageEngine(db, options);
+
+    BufferPoolManager *buffer_pool_manager =
+        storage_engine_->buffer_pool_manager_;
+    LockManager *lock_manager = storage_engine_->lock_manager_;
+    LogManager *log_manager = storage_engine_->log_manager_;
+
+    // Retrieve table and index root page info from header page
+    HeaderPage *header_page = static_cast<HeaderPage *>(
+        buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+    page_id_t table_root_id;
+    bool found = header_page->GetRootId(std::string(argv[2]), table_root_id);
+    page_id_t index_root_id = INVALID_PAGE_ID;
+    if (index_metadata != nullptr)
+      header_page->GetRootId(index_metadata->GetName(), index_root_id);
+    buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
+    if (!found) {
+      delete index_metadata;
+      throw Exception(EXCEPTION_TYPE_CATALOG, "table " + std::string(argv[2]) +
+                                                  " not found in header page");
+    }
+
     // create index object, allocate memory space
-    IndexMetadata *index_metadata =
-        ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    // Retrieve index root page info from header page
-    page_id_t index_root_id;
-    header_page->GetRootId(index_metadata->GetName(), index_root_id);
-    index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
+    Index *index = nullptr;
+    if (index_metadata != nullptr)
+      index =
+          ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
+    VirtualTable *table =
+        new VirtualTable(schema.release(), buffer_pool_manager, lock_manager,
+                         log_manager, index, table_root_id);
+
+    // register virtual table within sqlite system
+    schema_string = "CREATE TABLE X(" + schema_string + ");";
+    assert(sqlite3_declare_vtab(db, schema_string.c_str()) == SQLITE_OK);
+
+    *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
+    return SQLITE_OK;
+  } catch (std::exception &e) {
+    *pzErr = sqlite3_mprintf("%s", e.what());
+    return SQLITE_ERROR;
   }
-  VirtualTable *table =
-      new VirtualTable(schema, buffer_pool_manager, lock_manager, log_manager,
-                       index, table_root_id);
-
-  // register virtual table within sqlite system
-  schema_string = "CREATE TABLE X(" + schema_string + ");";
-  assert(sqlite3_declare_vtab(db, schema_string.c_str()) == SQLITE_OK);
-
-  *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
-  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
-  return SQLITE_OK;
 }
 
 /*
@@ -153,6 +233,7 @@ int VtabDisconnect(sqlite3_vtab *pVtab) {
   delete virtual_table;
   // delete all the global managers
   delete storage_engine_;
+  storage_engine_ = nullptr;
   return SQLITE_OK;
 }
 
@@ -189,13 +270,19 @@ int VtabFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum, const char *idxStr,
   // LOG_DEBUG("VtabFilter");
   Cursor *cursor = reinterpret_cast<Cursor *>(pVtabCursor);
   Schema *key_schema;
-  // if indexed scan
-  if (idxNum == 1) {
-    cursor->SetScanFlag(true);
-    // Construct the tuple for point query
-    key_schema = cursor->GetKeySchema();
-    Tuple scan_tuple = ConstructTuple(key_schema, argv);
-    cursor->ScanKey(scan_tuple);
+  try {
+    // if indexed scan
+    if (idxNum == 1) {
+      cursor->SetScanFlag(true);
+      // Construct the tuple for point query
+      key_schema = cursor->GetKeySchema();
+      Tuple scan_tuple = ConstructTuple(key_schema, argv);
+      cursor->ScanKey(scan_tuple);
+    }
+  } catch (std::bad_alloc &) {
+    return SQLITE_NOMEM;
+  } catch (std::exception &e) {
+    return VtabError(pVtabCursor->pVtab, e);
   }
   return SQLITE_OK;
 }
@@ -203,7 +290,13 @@ int VtabFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum, const char *idxStr,
 int VtabNext(sqlite3_vtab_cursor *cur) {
   // LOG_DEBUG("VtabNext");
   Cursor *cursor = reinterpret_cast<Cursor *>(cur);
-  ++(*cursor);
+  try {
+    ++(*cursor);
+  } catch (std::bad_alloc &) {
+    return SQLITE_NOMEM;
+  } catch (std::exception &e) {
+    return VtabError(cur->pVtab, e);
+  }
   return SQLITE_OK;
 }
 
@@ -257,44 +350,53 @@ int VtabRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
 int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
                sqlite_int64 *pRowid) {
   // LOG_DEBUG("VtabUpdate");
-  VirtualTable *table = reinterpret_cast<VirtualTable *>(pVTab);
-  // The single row with rowid equal to argv[0] is deleted
-  if (argc == 1) {
-    const RID rid(sqlite3_value_int64(argv[0]));
-    // delete entry from index
-    table->DeleteEntry(rid);
-    // delete tuple from table heap
-    table->DeleteTuple(rid);
+  if (storage_engine_->disk_manager_->IsReadOnly()) {
+    return SQLITE_READONLY;
   }
-  // A new row is inserted with a rowid argv[1] and column values in argv[2] and
-  // following. If argv[1] is an SQL NULL, the a new unique rowid is generated
-  // automatically.
-  else if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
-    Schema *schema = table->GetSchema();
-    Tuple tuple = ConstructTuple(schema, (argv + 2));
-    // insert into table heap
-    RID rid;
-    table->InsertTuple(tuple, rid);
-    // insert into index
-    table->InsertEntry(tuple, rid);
-  }
-  // The row with rowid argv[0] is updated with new values in argv[2] and
-  // following parameters.
-  else if (argc > 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL) {
-    Schema *schema = table->GetSchema();
-    Tuple tuple = ConstructTuple(schema, (argv + 2));
-    RID rid(sqlite3_value_int64(argv[0]));
-    // for update, index always delete and insert
-    // because you have no clue key has been updated or not
-    table->DeleteEntry(rid);
-    // if true, then update succeed, rid keep the same
-    // else, delete & insert
-    if (table->UpdateTuple(tuple, rid) == false) {
+  VirtualTable *table = reinterpret_cast<VirtualTable *>(pVTab);
+  try {
+    // The single row with rowid equal to argv[0] is deleted
+    if (argc == 1) {
+      const RID rid(sqlite3_value_int64(argv[0]));
+      // delete entry from index
+      table->DeleteEntry(rid);
+      // delete tuple from table heap
       table->DeleteTuple(rid);
-      // rid should be different
+    }
+    // A new row is inserted with a rowid argv[1] and column values in argv[2]
+    // and following. If argv[1] is an SQL NULL, the a new unique rowid is
+    // generated automatically.
+    else if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
+      Schema *schema = table->GetSchema();
+      Tuple tuple = ConstructTuple(schema, (argv + 2));
+      // insert into table heap
+      RID rid;
       table->InsertTuple(tuple, rid);
+      // insert into index
+      table->InsertEntry(tuple, rid);
+    }
+    // The row with rowid argv[0] is updated with new values in argv[2] and
+    // following parameters.
+    else if (argc > 1 && sqlite3_value_type(argv[0]) != SQLITE_NULL) {
+      Schema *schema = table->GetSchema();
+      Tuple tuple = ConstructTuple(schema, (argv + 2));
+      RID rid(sqlite3_value_int64(argv[0]));
+      // for update, index always delete and insert
+      // because you have no clue key has been updated or not
+      table->DeleteEntry(rid);
+      // if true, then update succeed, rid keep the same
+      // else, delete & insert
+      if (table->UpdateTuple(tuple, rid) == false) {
+        table->DeleteTuple(rid);
+        // rid should be different
+        table->InsertTuple(tuple, rid);
+      }
+      table->InsertEntry(tuple, rid);
     }
-    table->InsertEntry(tuple, rid);
+  } catch (std::bad_alloc &) {
+    return SQLITE_NOMEM;
+  } catch (std::exception &e) {
+    return VtabError(pVTab, e);
   }
   return SQLITE_OK;
 }
@@ -354,23 +456,8 @@ __declspec(dllexport)
     extern "C" int sqlite3_vtable_init(sqlite3 *db, char **pzErrMsg,
                                        const sqlite3_api_routines *pApi) {
   SQLITE_EXTENSION_INIT2(pApi);
-  std::string db_file_name = "vtable.db";
-  struct stat buffer;
-  bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
-
-  // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
-  // start the logging
-  storage_engine_->log_manager_->RunFlushThread();
-  // create header page from BufferPoolManager if necessary
-  if (!is_file_exist) {
-    page_id_t header_page_id;
-    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
-
-    assert(header_page_id == HEADER_PAGE_ID);
-    storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
-  }
-
+  // storage engine is opened by the first virtual table, which may set the
+  // page size of a new db file
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
   return rc;
 }
@@ -438,7 +525,7 @@ Schema *ParseCreateStatement(const std::string &sql_base) {
 
 IndexMetadata *ParseIndexStatement(std::string &sql,
                                    const std::string &table_name,
-                                   Schema *schema) {
+                                   Schema *schema, IndexType index_type) {
   std::string::size_type n;
   std::string index_name;
   std::vector<int> key_attrs;
@@ -463,12 +550,97 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
 
   IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+      new IndexMetadata(index_name, table_name, schema, key_attrs, index_type);
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
 }
 
+// index type argument: 'bplustree' (default), 'blinktree' or 'hash', quotes
+// are optional
+IndexType ParseIndexType(std::string type) {
+  std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+  if (type.size() >= 2 && (type.front() == '\'' || type.front() == '"'))
+    type = type.substr(1, type.size() - 2);
+  StringUtility::Trim(type);
+  if (type == "hash")
+    return IndexType::HASH;
+  if (type == "bplustree" || type == "btree")
+    return IndexType::BPLUSTREE;
+  if (type == "blinktree" || type == "blink")
+    return IndexType::BLINKTREE;
+  throw Exception(EXCEPTION_TYPE_INDEX, "unknown index type " + type);
+}
+
+std::vector<std::string> ParseModuleArgs(int argc, const char *const *argv,
+                                         ModuleOptions &options) {
+  std::vector<std::string> args;
+  for (int i = 4; i < argc; i++) {
+    std::string arg(argv[i]);
+    StringUtility::Trim(arg);
+    std::string::size_type n = arg.find('=');
+    if (n == std::string::npos || arg.front() == '\'' || arg.front() == '"') {
+      args.push_back(arg);
+      continue;
+    }
+    std::string key = arg.substr(0, n);
+    std::string value = arg.substr(n + 1);
+    StringUtility::Trim(key);
+    StringUtility::Trim(value);
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    char *end = nullptr;
+    long number = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < 0 ||
+        (number == 0 && key != "compression"))
+      throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                      "invalid value of option " + key + ": " + value);
+    if (key == "page_size") {
+      if (!DiskManager::IsValidPageSize(static_cast<uint32_t>(number)))
+        throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                        "unsupported page size " + value);
+      options.page_size = static_cast<int>(number);
+    } else if (key == "pool_size") {
+      if (number < MIN_BUFFER_POOL_SIZE)
+        throw Exception(EXCEPTION_TYPE_OUT_OF_RANGE,
+                        "pool size " + value + " is below the minimum of " +
+                            std::to_string(MIN_BUFFER_POOL_SIZE) + " frames");
+      options.pool_size = static_cast<size_t>(number);
+    } else if (key == "compression") {
+      options.compression = number != 0;
+    } else {
+      throw Exception(EXCEPTION_TYPE_SYNTAX, "unknown option " + key);
+    }
+  }
+  return args;
+}
+
+void InitStorageEngine(sqlite3 *db, const ModuleOptions &options) {
+  if (storage_engine_ != nullptr)
+    return;
+  std::string db_file_name = "vtable.db";
+  struct stat buffer;
+  bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
+
+  // a new db file gets the requested format, an existing one keeps its own
+  if (!is_file_exist)
+    PAGE_SIZE = options.page_size;
+  ENABLE_PAGE_COMPRESSION = options.compression;
+  // init storage engine, a read-only connection maps an existing db file
+  bool read_only = is_file_exist && sqlite3_db_readonly(db, "main") == 1;
+  storage_engine_ =
+      new StorageEngine(db_file_name, read_only, options.pool_size);
+  // start the logging
+  storage_engine_->log_manager_->RunFlushThread();
+  // create header page from BufferPoolManager if necessary
+  if (!is_file_exist) {
+    page_id_t header_page_id;
+    storage_engine_->buffer_pool_manager_->NewPage(header_page_id);
+
+    assert(header_page_id == HEADER_PAGE_ID);
+    storage_engine_->buffer_pool_manager_->UnpinPage(header_page_id, true);
+  }
+}
+
 Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   int column_count = schema->GetColumnCount();
   Value v(TypeId::INVALID);
@@ -504,6 +676,19 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
   return tuple;
 }
 
+template <size_t KeySize>
+static Index *ConstructIndexOfSize(IndexMetadata *metadata,
+                                   BufferPoolManager *buffer_pool_manager,
+                                   page_id_t root_id) {
+  if (metadata->GetIndexType() == IndexType::HASH)
+    return new ExtendibleHashIndex<GenericKey<KeySize>, RID,
+                                   GenericComparator<KeySize>>(
+        metadata, buffer_pool_manager, root_id);
+  return new BPlusTreeIndex<GenericKey<KeySize>, RID,
+                            GenericComparator<KeySize>>(
+      metadata, buffer_pool_manager, root_id);
+}
+
 // serve the functionality of index factory
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
@@ -515,20 +700,15 @@ Index *ConstructIndex(IndexMetadata *metadata,
   key_size += 16 * key_schema->GetUnlinedColumnCount();
 
   if (key_size <= 4) {
-    return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<4>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 8) {
-    return new BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<8>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 16) {
-    return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<16>(metadata, buffer_pool_manager, root_id);
   } else if (key_size <= 32) {
-    return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<32>(metadata, buffer_pool_manager, root_id);
   } else {
-    return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
-        metadata, buffer_pool_manager, root_id);
+    return ConstructIndexOfSize<64>(metadata, buffer_pool_manager, root_id);
   }
 }
 
@@ -2,7 +2,11 @@
  * buffer_pool_manager_test.cpp
  */
 
+#include <chrono>
 #include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
@@ -45,6 +49,369 @@ TEST(BufferPoolManagerTest, SampleTest) {
   // check read content
   EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
 
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, MultiInstanceTest) {
+  const int num_threads = 4;
+  const int num_pages = 50;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(16, disk_manager, nullptr, 4);
+
+  // every thread creates more pages than the whole pool can hold
+  std::vector<std::thread> threads;
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &bpm, &page_ids]() {
+      for (int i = 0; i < num_pages; i++) {
+        page_id_t page_id;
+        Page *page = bpm.NewPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+        page_ids[tid].push_back(page_id);
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // read everything back, evicting and reloading pages across instances
+  for (int tid = 0; tid < num_threads; tid++) {
+    EXPECT_FALSE(page_ids[tid].empty());
+    for (page_id_t page_id : page_ids[tid]) {
+      Page *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, atoi(page->GetData()));
+      EXPECT_EQ(true, bpm.UnpinPage(page_id, false));
+    }
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchTest) {
+  const int num_threads = 8;
+  const int num_pages = 20;
+  const int num_rounds = 200;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(4, disk_manager);
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+
+  // threads keep missing on overlapping pages, every fetch must see the
+  // content that was written back when the page was evicted
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &bpm]() {
+      for (int i = 0; i < num_rounds; i++) {
+        page_id_t page_id = (tid + i * 7) % num_pages;
+        Page *page = bpm.FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(page_id, atoi(page->GetData()));
+        EXPECT_EQ(true, bpm.UnpinPage(page_id, i % 2 == 0));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlushTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager);
+  bpm.RunFlushThread(1.0);
+
+  for (int i = 0; i < 5; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // a pinned dirty page is left alone
+  page_id_t pinned_page_id;
+  Page *pinned_page = bpm.NewPage(pinned_page_id);
+  ASSERT_NE(nullptr, pinned_page);
+  strcpy(pinned_page->GetData(), "pinned");
+
+  // wait for the writer however long its passes take under load
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+  while (disk_manager->GetNumWrites() < 5 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(BUFFER_POOL_FLUSH_TIMEOUT);
+  }
+  bpm.StopFlushThread();
+  EXPECT_EQ(5, disk_manager->GetNumWrites());
+
+  // the unpinned pages reached disk without being evicted
+  char buffer[MAX_PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    memset(buffer, 0, PAGE_SIZE);
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ("page " + std::to_string(i), std::string(buffer));
+  }
+  memset(buffer, 0, PAGE_SIZE);
+  disk_manager->ReadPage(pinned_page_id, buffer);
+  EXPECT_NE(std::string("pinned"), std::string(buffer));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, FlushAllPagesTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 2);
+
+  // dirty pages in both instances
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    Page *page = bpm.NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // pinned dirty pages are written as well
+  Page *page = bpm.FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  // nothing is evicted, so nothing was written yet
+  EXPECT_EQ(0, disk_manager->GetNumWrites());
+  size_t bytes_written = 0;
+  EXPECT_EQ(8u, bpm.FlushAllPages(&bytes_written));
+  EXPECT_EQ(8u * PAGE_SIZE, bytes_written);
+  // one sync for the whole checkpoint
+  EXPECT_EQ(8, disk_manager->GetNumWrites());
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  // clean pages are not written again
+  EXPECT_EQ(0u, bpm.FlushAllPages(&bytes_written));
+  EXPECT_EQ(0u, bytes_written);
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  EXPECT_EQ(true, bpm.UnpinPage(3, true));
+  EXPECT_EQ(1u, bpm.FlushAllPages());
+  EXPECT_EQ(9, disk_manager->GetNumWrites());
+  EXPECT_EQ(2, disk_manager->GetNumSyncs());
+
+  char buffer[MAX_PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ("page " + std::to_string(i), std::string(buffer));
+  }
+
+  delete disk_manager;
+  remove("test.db");
+
+  // bytes written are the compressed size of the pages
+  PAGE_SIZE = 4096;
+  ENABLE_PAGE_COMPRESSION = true;
+  disk_manager = new DiskManager("test.db");
+  ENABLE_PAGE_COMPRESSION = false;
+  BufferPoolManager *compressed_bpm =
+      new BufferPoolManager(10, disk_manager, nullptr, 2);
+  for (int i = 0; i < 8; ++i) {
+    page_id_t page_id;
+    Page *page = compressed_bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, compressed_bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(8u, compressed_bpm->FlushAllPages(&bytes_written));
+  EXPECT_LT(bytes_written, 8u * PAGE_SIZE);
+  EXPECT_EQ(8u * DIRECT_IO_ALIGNMENT, bytes_written);
+  delete compressed_bpm;
+  delete disk_manager;
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, DeletePageTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(3, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_NE(nullptr, bpm.NewPage(page_id));
+    EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  }
+  // pinned pages can not be deleted
+  ASSERT_NE(nullptr, bpm.FetchPage(4));
+  EXPECT_EQ(false, bpm.DeletePage(4));
+  EXPECT_EQ(true, bpm.UnpinPage(4, false));
+  // page 1 has been evicted, it is freed on disk all the same
+  EXPECT_EQ(true, bpm.DeletePage(1));
+  EXPECT_EQ(true, bpm.DeletePage(4));
+  ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(1, page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  ASSERT_NE(nullptr, bpm.NewPage(page_id));
+  EXPECT_EQ(4, page_id);
+  EXPECT_EQ(true, bpm.UnpinPage(page_id, true));
+  EXPECT_EQ(6, disk_manager->GetNumPages());
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 8; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "old %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(8u, bpm->FlushAllPages());
+  delete bpm;
+
+  bpm = new BufferPoolManager(5, disk_manager);
+  // pages beyond the last allocated page are ignored
+  bpm->PrefetchPages(3, 10);
+  bpm->WaitForPrefetch();
+
+  // change pages on disk behind the buffer pool's back, prefetched pages
+  // still hold the old content
+  char buffer[MAX_PAGE_SIZE];
+  for (int i = 0; i < 8; ++i) {
+    snprintf(buffer, PAGE_SIZE, "new %d", i);
+    disk_manager->WritePage(i, buffer);
+  }
+  for (int i = 7; i >= 0; --i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    std::string expected = (i >= 3 ? "old " : "new ") + std::to_string(i);
+    EXPECT_EQ(expected, std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  // falls back to buffered I/O where the file system has no O_DIRECT
+  DiskManager *disk_manager = new DiskManager("test.db", true);
+  BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+
+  page_id_t page_id;
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(page->GetData()) %
+                      DIRECT_IO_ALIGNMENT);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  // unaligned buffers work as well
+  char buffer[MAX_PAGE_SIZE + 1];
+  disk_manager->ReadPage(3, buffer + 1);
+  EXPECT_EQ("page 3", std::string(buffer + 1));
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, ReadOnlyTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(5, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 10; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", false, true);
+  bpm = new BufferPoolManager(3, disk_manager);
+  EXPECT_EQ(true, disk_manager->IsReadOnly());
+  EXPECT_EQ(10, disk_manager->GetNumPages());
+  bpm->PrefetchPages(0, 10);
+  for (int i = 9; i >= 0; --i) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    // served from the mapping, not copied
+    EXPECT_EQ(disk_manager->GetPageData(i), page->GetData());
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  // nothing can be changed
+  EXPECT_EQ(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(false, bpm->DeletePage(3));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+}
+
+TEST(BufferPoolManagerTest, CorruptPageTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id;
+  for (int i = 0; i < 4; ++i) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    EXPECT_EQ(true, bpm->UnpinPage(page_id, true));
+  }
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // flip a byte of page 2, pages follow bitmap page 0 in the db file
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, 3 * PAGE_SIZE, SEEK_SET);
+  fputc('q', file);
+  fclose(file);
+
+  bpm = new BufferPoolManager(4, disk_manager);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  for (page_id_t i : {0, 1, 3}) {
+    Page *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(i), std::string(page->GetData()));
+  }
+  // the frame of the corrupt page went back to the free list
+  ASSERT_NE(nullptr, bpm->NewPage(page_id));
+  EXPECT_EQ(4, page_id);
+  for (page_id_t i : {0, 1, 3, 4}) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  delete bpm;
+
+  delete disk_manager;
   remove("test.db");
 }
 
@@ -0,0 +1,86 @@
+/**
+ * clock_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ClockReplacerTest, SampleTest) {
+  Page *frames = new Page[6];
+  ClockReplacer clock_replacer(frames, 6);
+
+  // unpin every frame, all of them get their reference bit set
+  for (int i = 0; i < 6; i++) {
+    clock_replacer.Insert(&frames[i]);
+  }
+  clock_replacer.Insert(&frames[0]);
+  EXPECT_EQ(6, clock_replacer.Size());
+
+  // first sweep clears all reference bits, then frames go in hand order
+  Page *value;
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(&frames[0], value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(&frames[1], value);
+
+  // frame 3 is pinned and unpinned again, it gets a second chance
+  EXPECT_EQ(true, clock_replacer.Erase(&frames[3]));
+  EXPECT_EQ(false, clock_replacer.Erase(&frames[3]));
+  clock_replacer.Insert(&frames[3]);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(&frames[2], value);
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(&frames[4], value);
+
+  // remove element from replacer
+  EXPECT_EQ(false, clock_replacer.Erase(&frames[0]));
+  EXPECT_EQ(true, clock_replacer.Erase(&frames[5]));
+  EXPECT_EQ(1, clock_replacer.Size());
+  EXPECT_EQ(true, clock_replacer.Victim(value));
+  EXPECT_EQ(&frames[3], value);
+  EXPECT_EQ(false, clock_replacer.Victim(value));
+
+  delete[] frames;
+}
+
+TEST(ClockReplacerTest, BufferPoolTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager bpm(10, disk_manager, nullptr, 1, ReplacerType::CLOCK);
+
+  auto page_zero = bpm.NewPage(temp_page_id);
+  ASSERT_NE(nullptr, page_zero);
+  strcpy(page_zero->GetData(), "Hello");
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // unpin the first five pages, they are the only candidates for eviction
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, true));
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm.NewPage(temp_page_id));
+  }
+  EXPECT_EQ(nullptr, bpm.NewPage(temp_page_id));
+
+  // page zero was written back when it got evicted
+  for (int i = 5; i < 10; ++i) {
+    EXPECT_EQ(true, bpm.UnpinPage(i, false));
+  }
+  page_zero = bpm.FetchPage(0);
+  ASSERT_NE(nullptr, page_zero);
+  EXPECT_EQ(0, strcmp(page_zero->GetData(), "Hello"));
+
+  delete disk_manager;
+  remove("test.db");
+}
+
+} // namespace cmudb
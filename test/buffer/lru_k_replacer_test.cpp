@@ -0,0 +1,108 @@
+/**
+ * lru_k_replacer_test.cpp
+ */
+
+#include <cstdio>
+
+#include "buffer/lru_k_replacer.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0);
+
+  // 1 and 2 are referenced twice, everything else once
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(3);
+  lru_k_replacer.Insert(4);
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(5);
+  lru_k_replacer.Insert(2);
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // values with a single reference go first, in LRU order
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+
+  // pinning keeps the history, 5 gets its second reference
+  EXPECT_EQ(true, lru_k_replacer.Erase(5));
+  EXPECT_EQ(false, lru_k_replacer.Erase(5));
+  lru_k_replacer.Insert(5);
+
+  // then the oldest second-to-last reference
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(5, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 2);
+
+  // hot working set, referenced repeatedly with other references in between
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 4; i++) {
+      lru_k_replacer.Insert(i);
+    }
+  }
+  // a scan touches every page several times in a row, those references are
+  // correlated and count only once
+  for (int i = 100; i < 110; i++) {
+    for (int tuple = 0; tuple < 5; tuple++) {
+      lru_k_replacer.Insert(i);
+    }
+  }
+  for (int i = 0; i < 4; i++) {
+    lru_k_replacer.Insert(i);
+  }
+
+  // the scan pages are evicted before any page of the working set
+  int value;
+  for (int i = 100; i < 110; i++) {
+    EXPECT_EQ(true, lru_k_replacer.Victim(value));
+    EXPECT_LE(100, value);
+  }
+  EXPECT_EQ(4, lru_k_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, ForgetAndPrefetchTest) {
+  LRUKReplacer<int> lru_k_replacer(2, 0);
+
+  // 1 is hot, then its frame is freed and reused for a new page
+  lru_k_replacer.Insert(1);
+  lru_k_replacer.Insert(2);
+  lru_k_replacer.Insert(1);
+  EXPECT_EQ(true, lru_k_replacer.Erase(1));
+  lru_k_replacer.Forget(1);
+  lru_k_replacer.Insert(1);
+
+  // 3 and 4 are read ahead, 3 is then used once
+  lru_k_replacer.InsertUnreferenced(3);
+  lru_k_replacer.InsertUnreferenced(4);
+  EXPECT_EQ(true, lru_k_replacer.Erase(3));
+  lru_k_replacer.Insert(3);
+  EXPECT_EQ(4, lru_k_replacer.Size());
+
+  // the new page in frame 1 and the read ahead pages are all cold, in order
+  // of their last reference or read
+  int value;
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(2, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(1, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(4, value);
+  lru_k_replacer.Victim(value);
+  EXPECT_EQ(3, value);
+  EXPECT_EQ(false, lru_k_replacer.Victim(value));
+}
+
+} // namespace cmudb
@@ -2,7 +2,9 @@
  * lru_replacer_test.cpp
  */
 
+#include <chrono>
 #include <cstdio>
+#include <iostream>
 
 #include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
@@ -43,4 +45,33 @@ TEST(LRUReplacerTest, SampleTest) {
   EXPECT_EQ(1, value);
 }
 
+// Insert/Erase/Victim must not get slower as the number of frames grows
+TEST(LRUReplacerTest, ScalingBenchmark) {
+  const int num_ops = 100000;
+  for (int num_frames : {10, 1000, 100000, 1000000}) {
+    LRUReplacer<int> lru_replacer;
+    for (int i = 0; i < num_frames; i++) {
+      lru_replacer.Insert(i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_ops; i++) {
+      // re-pin and unpin a frame from the middle, then evict and reload one
+      int value = (i * 7919) % num_frames;
+      EXPECT_EQ(true, lru_replacer.Erase(value));
+      lru_replacer.Insert(value);
+      EXPECT_EQ(true, lru_replacer.Victim(value));
+      lru_replacer.Insert(value);
+    }
+    auto end = std::chrono::steady_clock::now();
+    EXPECT_EQ(num_frames, lru_replacer.Size());
+
+    double cost =
+        std::chrono::duration<double, std::nano>(end - start).count() /
+        (num_ops * 4);
+    std::cout << "frames: " << num_frames << ", ns per operation: " << cost
+              << std::endl;
+  }
+}
+
 } // namespace cmudb
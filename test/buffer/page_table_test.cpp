@@ -0,0 +1,160 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/page_table.h"
+#include "hash/extendible_hash.h"
+#include "page/page.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(PageTableTest, SampleTest) {
+  Page pages[4];
+  PageTable page_table(4);
+
+  page_table.Insert(1, &pages[0]);
+  page_table.Insert(2, &pages[1]);
+  page_table.Insert(3, &pages[2]);
+  page_table.Insert(1, &pages[3]);
+  EXPECT_EQ(3u, page_table.Size());
+
+  Page *page;
+  EXPECT_EQ(true, page_table.Find(1, page));
+  EXPECT_EQ(&pages[3], page);
+  EXPECT_EQ(true, page_table.Find(3, page));
+  EXPECT_EQ(&pages[2], page);
+  EXPECT_EQ(false, page_table.Find(4, page));
+
+  EXPECT_EQ(true, page_table.Remove(2));
+  EXPECT_EQ(false, page_table.Remove(2));
+  EXPECT_EQ(false, page_table.Find(2, page));
+  EXPECT_EQ(2u, page_table.Size());
+}
+
+TEST(PageTableTest, RandomTest) {
+  // collide a lot: many page ids, small table
+  const size_t capacity = 64;
+  Page pages[capacity];
+  PageTable page_table(capacity);
+  std::unordered_map<page_id_t, Page *> expected;
+  std::mt19937 rng(15445);
+
+  for (int i = 0; i < 100000; ++i) {
+    page_id_t page_id = rng() % 1024;
+    Page *page;
+    if (expected.count(page_id)) {
+      EXPECT_EQ(true, page_table.Find(page_id, page));
+      EXPECT_EQ(expected[page_id], page);
+      EXPECT_EQ(true, page_table.Remove(page_id));
+      expected.erase(page_id);
+    } else {
+      EXPECT_EQ(false, page_table.Find(page_id, page));
+      if (expected.size() < capacity) {
+        page_table.Insert(page_id, &pages[rng() % capacity]);
+        page_table.Find(page_id, expected[page_id]);
+      }
+    }
+  }
+  EXPECT_EQ(expected.size(), page_table.Size());
+  for (auto &kv : expected) {
+    Page *page;
+    EXPECT_EQ(true, page_table.Find(kv.first, page));
+    EXPECT_EQ(kv.second, page);
+  }
+}
+
+TEST(PageTableTest, ConcurrentTest) {
+  const size_t capacity = 128;
+  const int num_threads = 4;
+  Page pages[capacity];
+  PageTable page_table(capacity);
+  // even page ids stay in the table, odd ones come and go
+  for (size_t i = 0; i < capacity / 2; ++i) {
+    page_table.Insert(i * 2, &pages[i]);
+  }
+
+  std::vector<std::thread> threads;
+  threads.push_back(std::thread([&]() {
+    for (int run = 0; run < 2000; ++run) {
+      for (size_t i = 0; i < capacity / 2; ++i) {
+        page_table.Insert(i * 2 + 1, &pages[capacity / 2 + i]);
+      }
+      for (size_t i = 0; i < capacity / 2; ++i) {
+        page_table.Remove(i * 2 + 1);
+      }
+    }
+  }));
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&]() {
+      for (int run = 0; run < 20000; ++run) {
+        Page *page;
+        for (size_t i = 0; i < capacity / 2; i += 7) {
+          EXPECT_EQ(true, page_table.Find(i * 2, page));
+          EXPECT_EQ(&pages[i], page);
+          if (page_table.Find(i * 2 + 1, page)) {
+            EXPECT_EQ(&pages[capacity / 2 + i], page);
+          }
+        }
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+// lookups per second of a full table, as used by the buffer pool
+template <typename Table>
+double LookupThroughput(Table &table, size_t capacity, int num_threads) {
+  const int num_lookups = 1 << 20;
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.push_back(std::thread([&table, capacity, num_threads, tid]() {
+      Page *page;
+      for (int i = tid; i < num_lookups; i += num_threads) {
+        // three hits for every miss
+        page_id_t page_id = (i * 7919) % (capacity * 4 / 3);
+        table.Find(page_id, page);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return num_lookups / std::chrono::duration<double>(end - start).count();
+}
+
+TEST(PageTableTest, LookupBenchmark) {
+  const size_t capacity = 4096;
+  Page *pages = new Page[capacity];
+  PageTable page_table(capacity);
+  ExtendibleHash<page_id_t, Page *> extendible_hash(BUCKET_SIZE);
+  for (size_t i = 0; i < capacity; ++i) {
+    page_table.Insert(i, &pages[i]);
+    extendible_hash.Insert(i, &pages[i]);
+  }
+
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    double page_table_ops =
+        LookupThroughput(page_table, capacity, num_threads);
+    double extendible_hash_ops =
+        LookupThroughput(extendible_hash, capacity, num_threads);
+    std::cout << "threads: " << num_threads
+              << ", PageTable lookups/s: " << page_table_ops
+              << ", ExtendibleHash lookups/s: " << extendible_hash_ops
+              << std::endl;
+  }
+  delete[] pages;
+}
+
+} // namespace cmudb
@@ -0,0 +1,104 @@
+/**
+ * crc32c_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/crc32c.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(Crc32cTest, KnownValueTest) {
+  // test vectors of RFC 3720
+  std::vector<char> data(32, 0);
+  EXPECT_EQ(0x8a9136aau, Crc32c(data.data(), data.size()));
+  EXPECT_EQ(0x8a9136aau, Crc32cSoftware(data.data(), data.size()));
+  std::fill(data.begin(), data.end(), static_cast<char>(0xff));
+  EXPECT_EQ(0x62a8ab43u, Crc32c(data.data(), data.size()));
+  for (int i = 0; i < 32; ++i)
+    data[i] = static_cast<char>(i);
+  EXPECT_EQ(0x46dd794eu, Crc32c(data.data(), data.size()));
+  EXPECT_EQ(0xe3069283u, Crc32c("123456789", 9));
+  EXPECT_EQ(0xe3069283u, Crc32cSoftware("123456789", 9));
+  EXPECT_EQ(0u, Crc32c(nullptr, 0));
+}
+
+TEST(Crc32cTest, HardwareMatchesSoftwareTest) {
+  std::mt19937 rng(42);
+  std::vector<char> data(3 * 3 * 8192 + 100);
+  for (auto &c : data)
+    c = static_cast<char>(rng());
+  // unaligned starts and sizes around the interleaved block lengths
+  for (size_t size : {0, 1, 7, 8, 255, 768, 769, 4096, 24575, 24576, 50000}) {
+    for (size_t start : {0, 1, 3, 8}) {
+      EXPECT_EQ(Crc32cSoftware(data.data() + start, size),
+                Crc32c(data.data() + start, size));
+    }
+  }
+  // checksum of a concatenation continues the checksum of its prefix
+  uint32_t crc = Crc32c(data.data(), 1000);
+  EXPECT_EQ(Crc32c(data.data(), 30000), Crc32c(data.data() + 1000, 29000, crc));
+}
+
+TEST(Crc32cTest, PageChecksumBenchmark) {
+  PAGE_SIZE = 4096;
+  const int num_pages = 1024;
+  std::vector<char> page(PAGE_SIZE, 'x');
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (int i = 0; i < num_pages; ++i) {
+    disk_manager->WritePage(disk_manager->AllocatePage(), page.data());
+  }
+
+  // page reads are served from the OS page cache, the cheapest read there is
+  const int rounds = 8;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    for (page_id_t i = 0; i < num_pages; ++i) {
+      EXPECT_TRUE(disk_manager->ReadPage(i, page.data()));
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  double read_ns = std::chrono::duration<double, std::nano>(end - start).count() /
+                   (rounds * num_pages);
+
+  // keeps the checksums from being optimized away
+  volatile uint32_t sink = 0;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds * num_pages; ++r) {
+    sink = Crc32c(page.data(), PAGE_CONTENT_SIZE, r);
+  }
+  end = std::chrono::steady_clock::now();
+  double crc_ns = std::chrono::duration<double, std::nano>(end - start).count() /
+                  (rounds * num_pages);
+
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds * num_pages; ++r) {
+    sink = Crc32cSoftware(page.data(), PAGE_CONTENT_SIZE, r);
+  }
+  end = std::chrono::steady_clock::now();
+  double software_ns =
+      std::chrono::duration<double, std::nano>(end - start).count() /
+      (rounds * num_pages);
+
+  std::cout << "page size: " << PAGE_SIZE
+            << ", hardware crc32c: " << Crc32cHardware()
+            << ", verified read ns/page: " << read_ns
+            << ", checksum ns/page: " << crc_ns
+            << " (software " << software_ns << ")"
+            << ", checksum share of read: " << crc_ns / read_ns << std::endl;
+  (void)sink;
+
+  delete disk_manager;
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -0,0 +1,71 @@
+/**
+ * lz4_test.cpp
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/lz4.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// compress and decompress data, return compressed size
+static size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t size = Lz4Compress(data.data(), data.size(), compressed.data(),
+                            compressed.size());
+  EXPECT_NE(0u, size);
+  std::vector<char> decompressed(data.size());
+  EXPECT_TRUE(Lz4Decompress(compressed.data(), size, decompressed.data(),
+                            decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+  return size;
+}
+
+TEST(Lz4Test, RoundTripTest) {
+  std::mt19937 rng(7);
+  for (size_t size : {0, 1, 12, 13, 100, 4096, 65536}) {
+    // runs of zeros, as in a sparse page
+    std::vector<char> data(size, 0);
+    EXPECT_GE(size / 8 + 16, RoundTrip(data));
+    // text with repeated words, as in tuples
+    std::string text;
+    while (text.size() < size)
+      text += "tuple " + std::to_string(rng() % 100) + ", ";
+    data.assign(text.begin(), text.begin() + size);
+    RoundTrip(data);
+    // random bytes
+    for (auto &c : data)
+      c = static_cast<char>(rng());
+    RoundTrip(data);
+  }
+}
+
+TEST(Lz4Test, LimitTest) {
+  std::mt19937 rng(7);
+  std::vector<char> data(4096);
+  for (auto &c : data)
+    c = static_cast<char>(rng());
+  std::vector<char> compressed(4096);
+  // random data does not get smaller
+  EXPECT_EQ(0u, Lz4Compress(data.data(), data.size(), compressed.data(),
+                            compressed.size()));
+
+  std::fill(data.begin(), data.end(), 'a');
+  size_t size = Lz4Compress(data.data(), data.size(), compressed.data(),
+                            compressed.size());
+  ASSERT_NE(0u, size);
+  std::vector<char> decompressed(4096);
+  // wrong output size, truncated and corrupt input are rejected
+  EXPECT_FALSE(Lz4Decompress(compressed.data(), size, decompressed.data(),
+                             4095));
+  EXPECT_FALSE(Lz4Decompress(compressed.data(), size - 1, decompressed.data(),
+                             decompressed.size()));
+  compressed[2] = 0x7f;
+  EXPECT_FALSE(Lz4Decompress(compressed.data(), size, decompressed.data(),
+                             decompressed.size()));
+}
+
+} // namespace cmudb
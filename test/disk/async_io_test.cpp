@@ -0,0 +1,124 @@
+/**
+ * async_io_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <future>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+// write num_pages pages with many I/Os in flight, read them back likewise
+static void CheckBackend(AsyncIO *async_io) {
+  const int num_pages = 200;
+  std::vector<std::vector<char>> pages(num_pages,
+                                       std::vector<char>(PAGE_SIZE));
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(pages[i].data(), PAGE_SIZE, "page %d", i);
+    auto done = std::make_shared<std::promise<void>>();
+    futures.push_back(done->get_future());
+    async_io->Submit(true, pages[i].data(), PAGE_SIZE, i * PAGE_SIZE,
+                     [done](ssize_t rc) {
+                       EXPECT_EQ(PAGE_SIZE, rc);
+                       done->set_value();
+                     });
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+
+  futures.clear();
+  std::vector<std::vector<char>> reads(num_pages,
+                                       std::vector<char>(PAGE_SIZE));
+  for (int i = num_pages - 1; i >= 0; --i) {
+    auto done = std::make_shared<std::promise<void>>();
+    futures.push_back(done->get_future());
+    async_io->Submit(false, reads[i].data(), PAGE_SIZE, i * PAGE_SIZE,
+                     [done](ssize_t rc) {
+                       EXPECT_EQ(PAGE_SIZE, rc);
+                       done->set_value();
+                     });
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_EQ("page " + std::to_string(i), std::string(reads[i].data()));
+  }
+
+  // reads stop at end of file
+  std::promise<ssize_t> eof;
+  async_io->Submit(false, reads[0].data(), PAGE_SIZE, num_pages * PAGE_SIZE,
+                   [&eof](ssize_t rc) { eof.set_value(rc); });
+  EXPECT_EQ(0, eof.get_future().get());
+  // I/O errors are reported
+  std::promise<ssize_t> error;
+  async_io->Submit(false, reads[0].data(), PAGE_SIZE, -PAGE_SIZE,
+                   [&error](ssize_t rc) { error.set_value(rc); });
+  EXPECT_EQ(-EINVAL, error.get_future().get());
+}
+
+TEST(AsyncIOTest, IOUringTest) {
+  int fd = open("test.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_LE(0, fd);
+  IOUring *ring = IOUring::Create(fd, 8);
+  if (ring == nullptr) {
+    // kernel without io_uring
+    close(fd);
+    remove("test.db");
+    return;
+  }
+  CheckBackend(ring);
+  delete ring;
+  close(fd);
+  remove("test.db");
+}
+
+TEST(AsyncIOTest, ThreadPoolTest) {
+  int fd = open("test.db", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERT_LE(0, fd);
+  AsyncIO *pool = AsyncIO::Create(fd, false);
+  CheckBackend(pool);
+  delete pool;
+  close(fd);
+  remove("test.db");
+}
+
+TEST(AsyncIOTest, DiskManagerTest) {
+  for (bool direct_io : {false, true}) {
+    DiskManager *disk_manager = new DiskManager("test.db", direct_io);
+    // unaligned buffers, copied through aligned ones in direct I/O mode
+    char data[MAX_PAGE_SIZE + 1];
+    char buffer[MAX_PAGE_SIZE + 1];
+    for (int i = 0; i < 20; ++i) {
+      snprintf(data + 1, PAGE_SIZE, "page %d", i);
+      disk_manager->WritePage(disk_manager->AllocatePage(), data + 1);
+    }
+    disk_manager->ReadPageAsync(7, buffer + 1).get();
+    EXPECT_EQ("page 7", std::string(buffer + 1));
+
+    strcpy(data + 1, "rewritten");
+    disk_manager->WritePageAsync(7, data + 1).get();
+    disk_manager->ReadPage(7, buffer + 1);
+    EXPECT_EQ("rewritten", std::string(buffer + 1));
+
+    // a page past the end of the file
+    disk_manager->WritePageAsync(30, data + 1).get();
+    disk_manager->ReadPageAsync(30, buffer + 1).get();
+    EXPECT_EQ("rewritten", std::string(buffer + 1));
+
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+} // namespace cmudb
@@ -0,0 +1,370 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+#include "common/exception.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(DiskManagerTest, AllocateTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (page_id_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+  EXPECT_EQ(10, disk_manager->GetNumPages());
+
+  // lowest free page id is reused first
+  disk_manager->DeallocatePage(6);
+  disk_manager->DeallocatePage(3);
+  disk_manager->DeallocatePage(3);
+  EXPECT_EQ(10, disk_manager->GetNumPages());
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_EQ(6, disk_manager->AllocatePage());
+  EXPECT_EQ(10, disk_manager->AllocatePage());
+
+  // freeing the last pages lowers the high-water mark
+  disk_manager->DeallocatePage(8);
+  disk_manager->DeallocatePage(10);
+  EXPECT_EQ(10, disk_manager->GetNumPages());
+  disk_manager->DeallocatePage(9);
+  EXPECT_EQ(8, disk_manager->GetNumPages());
+  EXPECT_EQ(8, disk_manager->AllocatePage());
+  EXPECT_EQ(9, disk_manager->GetNumPages());
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, ExtentTest) {
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+
+  // each object gets whole extents, its pages are contiguous
+  page_id_t first = disk_manager->AllocateExtentPage(INVALID_PAGE_ID);
+  EXPECT_EQ(EXTENT_SIZE, first);
+  page_id_t other = disk_manager->AllocateExtentPage(INVALID_PAGE_ID);
+  EXPECT_EQ(2 * EXTENT_SIZE, other);
+  page_id_t page_id = first;
+  for (int i = 1; i < 2 * EXTENT_SIZE; ++i) {
+    page_id_t next = disk_manager->AllocateExtentPage(page_id);
+    // full extent continues in the next free one
+    EXPECT_EQ(i < EXTENT_SIZE ? page_id + 1 : 3 * EXTENT_SIZE + i - EXTENT_SIZE,
+              next);
+    page_id = next;
+  }
+  EXPECT_EQ(2 * EXTENT_SIZE + 1, disk_manager->AllocateExtentPage(other));
+
+  // other pages stay out of owned extents
+  for (page_id_t i = 1; i < EXTENT_SIZE; ++i) {
+    EXPECT_EQ(i, disk_manager->AllocatePage());
+  }
+  EXPECT_EQ(4 * EXTENT_SIZE, disk_manager->AllocatePage());
+
+  // an extent with no page left is free for anybody
+  disk_manager->DeallocatePage(other);
+  disk_manager->DeallocatePage(other + 1);
+  disk_manager->Sync();
+  delete disk_manager;
+
+  // extent ownership is persistent
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(4 * EXTENT_SIZE + 1, disk_manager->GetNumPages());
+  EXPECT_EQ(2 * EXTENT_SIZE, disk_manager->AllocatePage());
+  EXPECT_EQ(2 * EXTENT_SIZE + 1, disk_manager->AllocatePage());
+  EXPECT_EQ(5 * EXTENT_SIZE, disk_manager->AllocateExtentPage(INVALID_PAGE_ID));
+  disk_manager->DeallocatePage(EXTENT_SIZE + 5);
+  EXPECT_EQ(EXTENT_SIZE + 5, disk_manager->AllocateExtentPage(EXTENT_SIZE));
+  delete disk_manager;
+  remove("test.db");
+
+  // the last extent grows into the end of the db, not into a hole
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0, disk_manager->AllocateExtentPage(INVALID_PAGE_ID));
+  EXPECT_EQ(EXTENT_SIZE, disk_manager->AllocateExtentPage(INVALID_PAGE_ID));
+  page_id = disk_manager->AllocateExtentPage(INVALID_PAGE_ID);
+  EXPECT_EQ(2 * EXTENT_SIZE, page_id);
+  disk_manager->DeallocatePage(EXTENT_SIZE);
+  for (int i = 1; i < EXTENT_SIZE; ++i) {
+    page_id = disk_manager->AllocateExtentPage(page_id);
+  }
+  EXPECT_EQ(3 * EXTENT_SIZE, disk_manager->AllocateExtentPage(page_id));
+
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, RecoveryTest) {
+  // more pages than one bitmap page tracks
+  const page_id_t num_pages = BITMAP_PAGE_BITS + 100;
+  char data[MAX_PAGE_SIZE] = {0};
+  char buffer[MAX_PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id = disk_manager->AllocatePage();
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    disk_manager->WritePage(page_id, data);
+  }
+  disk_manager->DeallocatePage(5);
+  disk_manager->DeallocatePage(BITMAP_PAGE_BITS + 1);
+  disk_manager->DeallocatePage(num_pages - 1);
+  disk_manager->Sync();
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(num_pages - 1, disk_manager->GetNumPages());
+  for (page_id_t i : {0, 7, BITMAP_PAGE_BITS - 1, BITMAP_PAGE_BITS,
+                      num_pages - 2}) {
+    disk_manager->ReadPage(i, buffer);
+    EXPECT_EQ("page " + std::to_string(i), std::string(buffer));
+  }
+  // free pages of the previous run are reused
+  EXPECT_EQ(5, disk_manager->AllocatePage());
+  EXPECT_EQ(BITMAP_PAGE_BITS + 1, disk_manager->AllocatePage());
+  EXPECT_EQ(num_pages - 1, disk_manager->AllocatePage());
+  EXPECT_EQ(num_pages, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  // file holds the pages written plus one bitmap page per BITMAP_PAGE_BITS
+  // pages, the last page was cut off when it was deallocated
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat("test.db", &stat_buf));
+  EXPECT_EQ((num_pages + 1) * PAGE_SIZE, stat_buf.st_size);
+
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, CrashRecoveryTest) {
+  char data[MAX_PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (page_id_t i = 0; i < 10; ++i) {
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  disk_manager->Sync();
+  // pages allocated after the last sync, then the process dies
+  for (page_id_t i = 10; i < BITMAP_PAGE_BITS + 20; ++i) {
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  {
+    std::ifstream in("test.db", std::ios::binary);
+    std::ofstream out("crash.db", std::ios::binary);
+    out << in.rdbuf();
+  }
+  delete disk_manager;
+
+  // pages found in db file are not handed out again
+  disk_manager = new DiskManager("crash.db");
+  EXPECT_EQ(BITMAP_PAGE_BITS + 20, disk_manager->GetNumPages());
+  EXPECT_EQ(BITMAP_PAGE_BITS + 20, disk_manager->AllocatePage());
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+  remove("crash.db");
+  remove("crash.log");
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  char data[MAX_PAGE_SIZE] = {0};
+  char buffer[MAX_PAGE_SIZE] = {0};
+  PAGE_SIZE = 4096;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  page_id_t page_id = disk_manager->AllocatePage();
+  // content beyond the first 512 bytes survives
+  snprintf(data + PAGE_SIZE - 100, 100, "end of page");
+  disk_manager->WritePage(page_id, data);
+  delete disk_manager;
+
+  // reopening adopts the page size of the db file
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(4096, PAGE_SIZE);
+  EXPECT_EQ(1, disk_manager->GetNumPages());
+  disk_manager->ReadPage(page_id, buffer);
+  EXPECT_EQ("end of page", std::string(buffer + PAGE_SIZE - 100));
+
+  // a db file with another page size can't be created or opened next to it
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  EXPECT_THROW(new DiskManager("small.db"), Exception);
+  delete disk_manager;
+  remove("small.db");
+  remove("small.log");
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  disk_manager = new DiskManager("small.db");
+  disk_manager->AllocatePage();
+  disk_manager->Sync();
+  EXPECT_THROW(new DiskManager("test.db"), Exception);
+  EXPECT_EQ(MIN_PAGE_SIZE, PAGE_SIZE);
+  delete disk_manager;
+  remove("small.db");
+  remove("small.log");
+
+  EXPECT_FALSE(DiskManager::IsValidPageSize(1000));
+  EXPECT_FALSE(DiskManager::IsValidPageSize(2 * MAX_PAGE_SIZE));
+  EXPECT_TRUE(DiskManager::IsValidPageSize(MAX_PAGE_SIZE));
+
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  remove("test.db");
+  remove("test.log");
+}
+
+// flip one byte of page_id in the db file, pages follow bitmap page 0
+static void CorruptPage(page_id_t page_id, int pos) {
+  FILE *file = fopen("test.db", "r+b");
+  ASSERT_NE(nullptr, file);
+  fseek(file, (page_id + 1) * PAGE_SIZE + pos, SEEK_SET);
+  int c = fgetc(file);
+  fseek(file, (page_id + 1) * PAGE_SIZE + pos, SEEK_SET);
+  fputc(c ^ 0x01, file);
+  fclose(file);
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  char data[MAX_PAGE_SIZE] = {0};
+  char buffer[MAX_PAGE_SIZE] = {0};
+  DiskManager *disk_manager = new DiskManager("test.db");
+  for (int i = 0; i < 4; ++i) {
+    page_id_t page_id = disk_manager->AllocatePage();
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    disk_manager->WritePage(page_id, data);
+  }
+  // allocated but never written, the file has a hole of zeros there
+  disk_manager->AllocatePage();
+  snprintf(data, PAGE_SIZE, "page %d", 5);
+  disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  disk_manager->Sync();
+  delete disk_manager;
+
+  CorruptPage(1, 3);
+  CorruptPage(2, PAGE_SIZE - 1); // in the checksum itself
+  disk_manager = new DiskManager("test.db");
+  EXPECT_TRUE(disk_manager->ReadPage(0, buffer));
+  EXPECT_EQ("page 0", std::string(buffer));
+  EXPECT_FALSE(disk_manager->ReadPage(1, buffer));
+  EXPECT_FALSE(disk_manager->ReadPage(2, buffer));
+  EXPECT_TRUE(disk_manager->ReadPage(4, buffer));
+  EXPECT_FALSE(disk_manager->ReadPageAsync(1, buffer).get());
+  EXPECT_TRUE(disk_manager->ReadPageAsync(3, buffer).get());
+  EXPECT_EQ("page 3", std::string(buffer));
+  // rewriting a page stamps a fresh checksum
+  snprintf(data, PAGE_SIZE, "page %d", 1);
+  disk_manager->WritePage(1, data);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_EQ("page 1", std::string(buffer));
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+}
+
+static void RandomFill(char *data, int size) {
+  uint32_t x = 42;
+  for (int i = 0; i < size; ++i) {
+    x = x * 1103515245 + 12345;
+    data[i] = static_cast<char>(x >> 16);
+  }
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  const int num_pages = 100;
+  char data[MAX_PAGE_SIZE] = {0};
+  char buffer[MAX_PAGE_SIZE] = {0};
+  PAGE_SIZE = 4096;
+  ENABLE_PAGE_COMPRESSION = true;
+  DiskManager *disk_manager = new DiskManager("test.db");
+  ENABLE_PAGE_COMPRESSION = false;
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id = disk_manager->AllocatePage();
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", page_id);
+    // one page does not compress
+    if (page_id == 7) {
+      RandomFill(data, PAGE_CONTENT_SIZE);
+    }
+    if (i % 2 == 0) {
+      disk_manager->WritePage(page_id, data);
+    } else {
+      disk_manager->WritePageAsync(page_id, data).get();
+    }
+  }
+  // every compressed page takes one sector, page 7 a whole page
+  EXPECT_EQ((num_pages - 1) * DIRECT_IO_ALIGNMENT + PAGE_SIZE,
+            disk_manager->GetNumBytesWritten());
+  delete disk_manager;
+
+  // the format is kept when reopened
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  disk_manager = new DiskManager("test.db");
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  EXPECT_EQ(num_pages, disk_manager->GetNumPages());
+  for (page_id_t i = 0; i < num_pages; ++i) {
+    if (i % 2 == 0) {
+      EXPECT_TRUE(disk_manager->ReadPage(i, buffer));
+    } else {
+      EXPECT_TRUE(disk_manager->ReadPageAsync(i, buffer).get());
+    }
+    if (i != 7) {
+      EXPECT_EQ("page " + std::to_string(i), std::string(buffer));
+    }
+  }
+  // a page growing back to full size is rewritten in place
+  RandomFill(data, PAGE_CONTENT_SIZE);
+  disk_manager->WritePage(3, data);
+  EXPECT_TRUE(disk_manager->ReadPage(3, buffer));
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_CONTENT_SIZE));
+  EXPECT_TRUE(disk_manager->ReadPage(4, buffer));
+  EXPECT_EQ("page 4", std::string(buffer));
+  disk_manager->Sync();
+
+  // pages change size after the last sync, then the process dies with a
+  // stale page map
+  char random[MAX_PAGE_SIZE] = {0};
+  RandomFill(random, PAGE_CONTENT_SIZE);
+  disk_manager->WritePage(2, random);
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "page 3 again");
+  disk_manager->WritePage(3, data);
+  page_id_t page_id = disk_manager->AllocatePage();
+  snprintf(data, PAGE_SIZE, "page %d", page_id);
+  disk_manager->WritePageAsync(page_id, data).get();
+  {
+    std::ifstream in("test.db", std::ios::binary);
+    std::ofstream out("crash.db", std::ios::binary);
+    out << in.rdbuf();
+  }
+  delete disk_manager;
+
+  disk_manager = new DiskManager("crash.db");
+  EXPECT_TRUE(disk_manager->ReadPage(2, buffer));
+  EXPECT_EQ(0, memcmp(random, buffer, PAGE_CONTENT_SIZE));
+  EXPECT_TRUE(disk_manager->ReadPageAsync(2, buffer).get());
+  EXPECT_EQ(0, memcmp(random, buffer, PAGE_CONTENT_SIZE));
+  EXPECT_TRUE(disk_manager->ReadPage(3, buffer));
+  EXPECT_EQ("page 3 again", std::string(buffer));
+  EXPECT_TRUE(disk_manager->ReadPageAsync(3, buffer).get());
+  EXPECT_EQ("page 3 again", std::string(buffer));
+  EXPECT_TRUE(disk_manager->ReadPageAsync(page_id, buffer).get());
+  EXPECT_EQ("page " + std::to_string(page_id), std::string(buffer));
+  EXPECT_TRUE(disk_manager->ReadPage(4, buffer));
+  EXPECT_EQ("page 4", std::string(buffer));
+  delete disk_manager;
+
+  PAGE_SIZE = MIN_PAGE_SIZE;
+  remove("test.db");
+  remove("test.log");
+  remove("crash.db");
+  remove("crash.log");
+}
+
+} // namespace cmudb
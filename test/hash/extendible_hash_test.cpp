@@ -92,7 +92,8 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
     for (int i = 0; i < num_threads; i++) {
       threads[i].join();
     }
-    EXPECT_EQ(test->GetGlobalDepth(), 6);
+    // emptied buckets are merged, the directory may have shrunk
+    EXPECT_LE(test->GetGlobalDepth(), 6);
     int val;
     EXPECT_EQ(0, test->Find(0, val));
     EXPECT_EQ(1, test->Find(8, val));
@@ -102,4 +103,74 @@ TEST(ExtendibleHashTest, ConcurrentRemoveTest) {
   }
 }
 
+TEST(ExtendibleHashTest, ConcurrentSplitTest) {
+  const int num_threads = 8;
+  const int num_keys = 2000;
+  ExtendibleHash<int, int> test(4);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &test]() {
+      for (int i = tid; i < num_keys; i += num_threads) {
+        test.Insert(i, i);
+        int val;
+        EXPECT_TRUE(test.Find(i, val));
+        EXPECT_EQ(i, val);
+        // readers of keys owned by other threads
+        if (test.Find((i + 1) % num_keys, val)) {
+          EXPECT_EQ((i + 1) % num_keys, val);
+        }
+      }
+      for (int i = tid; i < num_keys; i += num_threads * 2) {
+        EXPECT_TRUE(test.Remove(i));
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i < num_keys; i++) {
+    int val;
+    bool removed = i % (num_threads * 2) < num_threads;
+    EXPECT_EQ(!removed, test.Find(i, val));
+  }
+}
+
+TEST(ExtendibleHashTest, ShrinkTest) {
+  ExtendibleHash<int, int> test(2);
+  for (int i = 0; i < 1000; i++) {
+    test.Insert(i, i);
+  }
+  int peak_depth = test.GetGlobalDepth();
+  EXPECT_GE(peak_depth, 9);
+
+  // keep every 100th key, the directory shrinks but they stay reachable
+  for (int i = 0; i < 1000; i++) {
+    if (i % 100 != 0) {
+      EXPECT_TRUE(test.Remove(i));
+    }
+  }
+  EXPECT_LT(test.GetGlobalDepth(), peak_depth);
+  for (int i = 0; i < 1000; i++) {
+    int val;
+    EXPECT_EQ(i % 100 == 0, test.Find(i, val));
+  }
+
+  for (int i = 0; i < 1000; i += 100) {
+    EXPECT_TRUE(test.Remove(i));
+  }
+  EXPECT_EQ(0, test.GetGlobalDepth());
+  EXPECT_EQ(1, test.GetNumBuckets());
+  EXPECT_EQ(0, test.GetLocalDepth(0));
+
+  // and it grows again
+  for (int i = 0; i < 1000; i++) {
+    test.Insert(i, i);
+  }
+  for (int i = 0; i < 1000; i++) {
+    int val;
+    EXPECT_TRUE(test.Find(i, val));
+    EXPECT_EQ(i, val);
+  }
+}
+
 } // namespace cmudb
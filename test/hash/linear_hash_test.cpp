@@ -0,0 +1,118 @@
+/**
+ * linear_hash_test.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "common/config.h"
+#include "hash/extendible_hash.h"
+#include "hash/linear_hash.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(LinearHashTest, SampleTest) {
+  LinearHash<int, std::string> *test = new LinearHash<int, std::string>(2);
+
+  // insert several key/value pairs
+  test->Insert(1, "a");
+  test->Insert(2, "b");
+  test->Insert(3, "c");
+  test->Insert(4, "d");
+  test->Insert(5, "e");
+  test->Insert(6, "f");
+  test->Insert(7, "g");
+  test->Insert(8, "h");
+  test->Insert(9, "i");
+  test->Insert(9, "j");
+  EXPECT_EQ(9u, test->Size());
+  // one split per insert beyond 2 pairs per bucket
+  EXPECT_EQ(5, test->GetNumBuckets());
+
+  // find test
+  std::string result;
+  test->Find(9, result);
+  EXPECT_EQ("j", result);
+  test->Find(8, result);
+  EXPECT_EQ("h", result);
+  test->Find(2, result);
+  EXPECT_EQ("b", result);
+  EXPECT_EQ(0, test->Find(10, result));
+
+  // delete test
+  EXPECT_EQ(1, test->Remove(8));
+  EXPECT_EQ(1, test->Remove(4));
+  EXPECT_EQ(1, test->Remove(1));
+  EXPECT_EQ(0, test->Remove(20));
+  EXPECT_EQ(0, test->Find(8, result));
+  EXPECT_EQ(6u, test->Size());
+
+  delete test;
+}
+
+TEST(LinearHashTest, ConcurrentInsertTest) {
+  const int num_threads = 4;
+  const int num_keys = 10000;
+  LinearHash<int, int> test(4);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &test]() {
+      for (int i = tid; i < num_keys; i += num_threads) {
+        test.Insert(i, i);
+      }
+    }));
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(static_cast<size_t>(num_keys), test.Size());
+  for (int i = 0; i < num_keys; i++) {
+    int val;
+    EXPECT_TRUE(test.Find(i, val));
+    EXPECT_EQ(i, val);
+  }
+}
+
+// per insert latency in ns, sorted
+std::vector<double> InsertLatencies(HashTable<int, int> &table, int num_keys) {
+  std::vector<double> latencies;
+  latencies.reserve(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    auto start = std::chrono::steady_clock::now();
+    table.Insert(i, i);
+    auto end = std::chrono::steady_clock::now();
+    latencies.push_back(
+        std::chrono::duration<double, std::nano>(end - start).count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+TEST(LinearHashTest, InsertLatencyBenchmark) {
+  const int num_keys = 200000;
+  LinearHash<int, int> linear_hash(BUCKET_SIZE);
+  ExtendibleHash<int, int> extendible_hash(BUCKET_SIZE);
+  std::vector<std::pair<std::string, std::vector<double>>> results;
+  results.emplace_back("LinearHash", InsertLatencies(linear_hash, num_keys));
+  results.emplace_back("ExtendibleHash",
+                       InsertLatencies(extendible_hash, num_keys));
+  for (auto &result : results) {
+    auto &latencies = result.second;
+    std::cout << result.first
+              << " insert ns p50: " << latencies[latencies.size() / 2]
+              << ", p99: " << latencies[latencies.size() * 99 / 100]
+              << ", p99.9: " << latencies[latencies.size() * 999 / 1000]
+              << ", max: " << latencies.back() << std::endl;
+  }
+
+  for (int i = 0; i < num_keys; i++) {
+    int val;
+    EXPECT_TRUE(linear_hash.Find(i, val));
+    EXPECT_EQ(i, val);
+  }
+}
+
+} // namespace cmudb
@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <functional>
 #include <iostream>
+#include <random>
 #include <thread>
 
 #include "buffer/buffer_pool_manager.h"
@@ -348,4 +349,327 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+// helper function to scan the whole tree while others modify it
+void ScanHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                int rounds, __attribute__((unused)) uint64_t thread_itr = 0) {
+  for (int round = 0; round < rounds; round++) {
+    int64_t last_key = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      int64_t key = (*iterator).second.GetSlotNum();
+      EXPECT_LT(last_key, key);
+      last_key = key;
+    }
+  }
+}
+
+// helper function to look up keys nobody removes while others modify the tree
+void LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                  const std::vector<int64_t> &keys,
+                  __attribute__((unused)) uint64_t thread_itr = 0) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), 1);
+  }
+}
+
+// helper function to check the tree holds exactly keys, in order
+void CheckKeys(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+               std::vector<int64_t> keys) {
+  std::sort(keys.begin(), keys.end());
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  size_t size = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    ASSERT_LT(size, keys.size());
+    EXPECT_EQ((*iterator).second.GetSlotNum(), keys[size]);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, keys.size());
+}
+
+TEST(BPlusTreeConcurrentTest, InsertScaleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  // fewer frames than tree pages, so pages are evicted while latched around
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // keys to Insert, in random order so that threads split the same pages
+  std::vector<int64_t> keys;
+  int64_t scale_factor = 30000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  LaunchParallelTest(16, InsertHelperSplit, std::ref(tree), keys, 16);
+
+  CheckKeys(tree, keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, DeleteScaleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  std::vector<int64_t> keys;
+  int64_t scale_factor = 30000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    keys.push_back(key);
+  }
+  LaunchParallelTest(16, InsertHelperSplit, std::ref(tree), keys, 16);
+
+  // remove all but every fourth key, merging most pages
+  std::vector<int64_t> remove_keys, remaining_keys;
+  for (auto key : keys) {
+    if (key % 4 == 0)
+      remaining_keys.push_back(key);
+    else
+      remove_keys.push_back(key);
+  }
+  std::shuffle(remove_keys.begin(), remove_keys.end(), std::mt19937(15445));
+  LaunchParallelTest(16, DeleteHelperSplit, std::ref(tree), remove_keys, 16);
+
+  CheckKeys(tree, remaining_keys);
+
+  // and then everything
+  LaunchParallelTest(16, DeleteHelperSplit, std::ref(tree), remaining_keys,
+                     16);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin().isEnd());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, MixScaleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // odd keys stay, even keys are removed while new keys are inserted
+  std::vector<int64_t> stable_keys, remove_keys, insert_keys;
+  int64_t scale_factor = 20000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    (key % 2 == 1 ? stable_keys : remove_keys).push_back(key);
+    insert_keys.push_back(scale_factor + key);
+  }
+  InsertHelper(tree, stable_keys);
+  InsertHelper(tree, remove_keys);
+
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < 8; i++) {
+    threads.emplace_back(InsertHelperSplit, std::ref(tree),
+                         std::cref(insert_keys), 8, i);
+    threads.emplace_back(DeleteHelperSplit, std::ref(tree),
+                         std::cref(remove_keys), 8, i);
+    threads.emplace_back(LookupHelper, std::ref(tree), std::cref(stable_keys),
+                         i);
+  }
+  for (uint64_t i = 0; i < 4; i++) {
+    threads.emplace_back(ScanHelper, std::ref(tree), 4, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<int64_t> keys = stable_keys;
+  keys.insert(keys.end(), insert_keys.begin(), insert_keys.end());
+  CheckKeys(tree, keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BLinkInsertScaleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // create b-link tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, BPlusTreeMode::B_LINK);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // keys to Insert, in random order so that threads split the same pages
+  std::vector<int64_t> keys;
+  int64_t scale_factor = 30000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < 16; i++) {
+    threads.emplace_back(InsertHelperSplit, std::ref(tree), std::cref(keys),
+                         16, i);
+  }
+  // scans run into pages split behind them
+  for (uint64_t i = 0; i < 4; i++) {
+    threads.emplace_back(ScanHelper, std::ref(tree), 4, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  CheckKeys(tree, keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, BLinkMixScaleTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(256, disk_manager);
+  // create b-link tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, BPlusTreeMode::B_LINK);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // odd keys stay, even keys are removed while new keys are inserted
+  std::vector<int64_t> stable_keys, remove_keys, insert_keys;
+  int64_t scale_factor = 20000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    (key % 2 == 1 ? stable_keys : remove_keys).push_back(key);
+    insert_keys.push_back(scale_factor + key);
+  }
+  InsertHelper(tree, stable_keys);
+  InsertHelper(tree, remove_keys);
+
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < 8; i++) {
+    threads.emplace_back(InsertHelperSplit, std::ref(tree),
+                         std::cref(insert_keys), 8, i);
+    threads.emplace_back(DeleteHelperSplit, std::ref(tree),
+                         std::cref(remove_keys), 8, i);
+    threads.emplace_back(LookupHelper, std::ref(tree), std::cref(stable_keys),
+                         i);
+  }
+  for (uint64_t i = 0; i < 4; i++) {
+    threads.emplace_back(ScanHelper, std::ref(tree), 4, i);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<int64_t> keys = stable_keys;
+  keys.insert(keys.end(), insert_keys.begin(), insert_keys.end());
+  CheckKeys(tree, keys);
+
+  // pages emptied are kept, the tree is empty all the same
+  LaunchParallelTest(16, DeleteHelperSplit, std::ref(tree), keys, 16);
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin().isEnd());
+  InsertHelper(tree, remove_keys);
+  CheckKeys(tree, remove_keys);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertThroughputBenchmark) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<int64_t> keys;
+  int64_t scale_factor = 20000;
+  for (int64_t key = 1; key < scale_factor; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  uint64_t num_threads =
+      std::max<uint64_t>(4, std::thread::hardware_concurrency());
+
+  for (auto mode : {BPlusTreeMode::CRABBING, BPlusTreeMode::B_LINK}) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    // large enough to hold the whole tree, latching is what is measured
+    BufferPoolManager *bpm = new BufferPoolManager(4096, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+        "foo_pk", bpm, comparator, INVALID_PAGE_ID, mode);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, InsertHelperSplit, std::ref(tree), keys,
+                       num_threads);
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << (mode == BPlusTreeMode::B_LINK ? "b-link" : "crabbing")
+              << " threads: " << num_threads
+              << ", inserts/s: " << keys.size() / seconds << std::endl;
+    CheckKeys(tree, keys);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
 } // namespace cmudb
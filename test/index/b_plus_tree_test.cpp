@@ -8,8 +8,10 @@
 #include <sstream>
 
 #include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -390,4 +392,90 @@ TEST(BPlusTreeTests, ScaleTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, OutOfMemoryTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(20, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  std::vector<page_id_t> pinned;
+  // every frame but a few pinned by someone else
+  auto pin_frames = [&](int64_t free_frames) {
+    while (bpm->NewPage(page_id) != nullptr)
+      pinned.push_back(page_id);
+    for (int64_t i = 0; i < free_frames; i++) {
+      bpm->UnpinPage(pinned.back(), false);
+      bpm->DeletePage(pinned.back());
+      pinned.pop_back();
+    }
+  };
+  auto unpin_frames = [&]() {
+    for (auto pinned_page_id : pinned) {
+      bpm->UnpinPage(pinned_page_id, false);
+      bpm->DeletePage(pinned_page_id);
+    }
+    pinned.clear();
+  };
+
+  int64_t scale = 1000;
+  int failed = 0;
+  for (int64_t key = 1; key <= scale; key++) {
+    index_key.SetFromInteger(key);
+    pin_frames(key % 7);
+    bool inserted = false;
+    try {
+      inserted = tree.Insert(index_key, RID(0, key));
+    } catch (Exception &) {
+      failed++;
+    }
+    unpin_frames();
+    if (!inserted) {
+      // nothing of the insert is left, latches and pins were released
+      rids.clear();
+      EXPECT_EQ(false, tree.GetValue(index_key, rids));
+      EXPECT_EQ(true, tree.Insert(index_key, RID(0, key)));
+    }
+  }
+  EXPECT_GT(failed, 0);
+
+  int64_t current_key = 1;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ(current_key, (*iterator).second.GetSlotNum());
+    current_key++;
+  }
+  EXPECT_EQ(scale + 1, current_key);
+
+  failed = 0;
+  for (int64_t key = 1; key <= scale; key++) {
+    index_key.SetFromInteger(key);
+    pin_frames(key % 7);
+    try {
+      tree.Remove(index_key);
+    } catch (Exception &) {
+      failed++;
+    }
+    unpin_frames();
+    tree.Remove(index_key);
+    rids.clear();
+    EXPECT_EQ(false, tree.GetValue(index_key, rids));
+  }
+  EXPECT_GT(failed, 0);
+  EXPECT_EQ(true, tree.IsEmpty());
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
 } // namespace cmudb
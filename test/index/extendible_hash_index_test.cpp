@@ -0,0 +1,244 @@
+/**
+ * extendible_hash_index_test.cpp
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "index/extendible_hash_table.h"
+#include "page/header_page.h"
+#include "vtable/virtual_table.h"
+#include "gtest/gtest.h"
+
+namespace cmudb {
+
+TEST(ExtendibleHashIndexTests, InsertRemoveTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create header_page
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  index_key.SetFromInteger(1);
+  EXPECT_EQ(false, table.GetValue(index_key, rids));
+
+  // enough keys for several levels of splits
+  const int64_t num_keys = 1000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= num_keys; key++)
+    keys.push_back(key);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.Insert(index_key, RID(key >> 32, key)));
+  }
+  index_key.SetFromInteger(keys[0]);
+  EXPECT_EQ(false, table.Insert(index_key, RID(0, 0)));
+  EXPECT_GT(table.GetGlobalDepth(), 0u);
+
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+    ASSERT_EQ(1u, rids.size());
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+
+  // the directory page is recorded in header page, reopen the table
+  page_id_t directory_page_id;
+  header_page = static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  EXPECT_EQ(true, header_page->GetRootId("foo_pk", directory_page_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> reopened(
+      "foo_pk", bpm, comparator, directory_page_id);
+
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    if (key % 10 != 0)
+      reopened.Remove(index_key);
+  }
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 10 == 0, reopened.GetValue(index_key, rids));
+  }
+  for (auto key : keys) {
+    index_key.SetFromInteger(key);
+    reopened.Remove(index_key);
+  }
+  // all buckets merged back into one
+  EXPECT_EQ(0u, reopened.GetGlobalDepth());
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ExtendibleHashIndexTests, ConcurrentTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  const int num_threads = 4;
+  const int64_t num_keys = 1000;
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.push_back(std::thread([tid, &table]() {
+      GenericKey<8> index_key;
+      std::vector<RID> rids;
+      for (int64_t key = tid; key < num_keys; key += num_threads) {
+        index_key.SetFromInteger(key);
+        EXPECT_EQ(true, table.Insert(index_key, RID(0, key)));
+        rids.clear();
+        EXPECT_EQ(true, table.GetValue(index_key, rids));
+      }
+      for (int64_t key = tid; key < num_keys; key += num_threads * 2) {
+        index_key.SetFromInteger(key);
+        table.Remove(index_key);
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    bool removed = key % (num_threads * 2) < num_threads;
+    EXPECT_EQ(!removed, table.GetValue(index_key, rids));
+  }
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ExtendibleHashIndexTests, OverflowTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  // many more keys than buckets of a full directory hold
+  const int64_t num_keys = 4 * (1 << DIRECTORY_MAX_DEPTH) *
+                           HashTableBucketPage<GenericKey<8>, RID,
+                                               GenericComparator<8>>::GetMaxSize();
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.Insert(index_key, RID(0, key)));
+  }
+  EXPECT_EQ(DIRECTORY_MAX_DEPTH, table.GetGlobalDepth());
+  index_key.SetFromInteger(num_keys / 2);
+  EXPECT_EQ(false, table.Insert(index_key, RID(0, 0)));
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+    ASSERT_EQ(1u, rids.size());
+    EXPECT_EQ(key, rids[0].GetSlotNum());
+  }
+
+  // overflow pages are given back as they empty, then buckets merge again
+  for (int64_t key = 0; key < num_keys; key++) {
+    index_key.SetFromInteger(key);
+    if (key % 2 == 0)
+      table.Remove(index_key);
+  }
+  for (int64_t key = 0; key < num_keys; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(key % 2 == 1, table.GetValue(index_key, rids));
+  }
+  for (int64_t key = 1; key < num_keys; key += 2) {
+    index_key.SetFromInteger(key);
+    table.Remove(index_key);
+  }
+  EXPECT_EQ(0u, table.GetGlobalDepth());
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(ExtendibleHashIndexTests, OutOfMemoryTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t page_id;
+  auto header_page = static_cast<HeaderPage *>(bpm->NewPage(page_id));
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+
+  ExtendibleHashTable<GenericKey<8>, RID, GenericComparator<8>> table(
+      "foo_pk", bpm, comparator);
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  index_key.SetFromInteger(1);
+  EXPECT_EQ(true, table.Insert(index_key, RID(0, 1)));
+
+  // every frame pinned by someone else
+  std::vector<page_id_t> pinned;
+  while (bpm->NewPage(page_id) != nullptr)
+    pinned.push_back(page_id);
+  index_key.SetFromInteger(2);
+  EXPECT_THROW(table.Insert(index_key, RID(0, 2)), Exception);
+  EXPECT_THROW(table.GetValue(index_key, rids), Exception);
+  EXPECT_THROW(table.Remove(index_key), Exception);
+
+  // the table latch and its pages were released on the way out
+  for (auto pinned_page_id : pinned)
+    bpm->UnpinPage(pinned_page_id, false);
+  EXPECT_EQ(true, table.Insert(index_key, RID(0, 2)));
+  for (int64_t key = 1; key <= 2; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_EQ(true, table.GetValue(index_key, rids));
+  }
+
+  delete key_schema;
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+} // namespace cmudb
@@ -41,7 +41,7 @@ TEST(LogManagerTest, BasicLogging) {
   LOG_DEBUG("Turning off flushing thread");
 
   // some basic manually checking here
-  char buffer[PAGE_SIZE];
+  char buffer[MAX_PAGE_SIZE];
   storage_engine->disk_manager_->ReadLog(buffer, PAGE_SIZE, 0);
   int32_t size = *reinterpret_cast<int32_t *>(buffer);
   LOG_DEBUG("size  = %d", size);
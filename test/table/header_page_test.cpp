@@ -5,11 +5,11 @@
 #include "page/header_page.h"
 #include "gtest/gtest.h"
 
-// NOTE: when you running this test, make sure page size(config.h) is at least
-// 4096
 namespace cmudb {
 
 TEST(HeaderPageTest, UnitTest) {
+  // 27 records need a page of at least 4096 bytes
+  PAGE_SIZE = 4096;
   DiskManager *disk_manager = new DiskManager("test.db");
   BufferPoolManager *buffer_pool_manager =
       new BufferPoolManager(20, disk_manager);
@@ -52,6 +52,7 @@ TEST(HeaderPageTest, UnitTest) {
 
   delete buffer_pool_manager;
   delete disk_manager;
+  PAGE_SIZE = MIN_PAGE_SIZE;
   remove("test.db");
   remove("test.log");
 }
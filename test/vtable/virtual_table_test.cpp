@@ -37,6 +37,27 @@ TEST(VtableTest, CreateTest) {
   EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1"));
   EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo1"));
 
+  // malformed module arguments fail the statement
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT', "
+                           "'foo2_pk a', 'btre')"));
+  EXPECT_FALSE(ExecSQL(
+      db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT', pool_sise=10)"));
+  EXPECT_FALSE(ExecSQL(
+      db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT', pool_size=3)"));
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT')"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+
+  // tables are created until the header page is full
+  int created = 0;
+  while (created < 200 &&
+         ExecSQL(db, "CREATE VIRTUAL TABLE bar" + std::to_string(created) +
+                         " USING vtable ('a INT')"))
+    created++;
+  EXPECT_GT(created, 14); // more than a 512-byte header page holds
+  EXPECT_LT(created, 200);
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO bar0 VALUES(1)"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM bar0"));
+
   rc = sqlite3_close(db);
   EXPECT_EQ(rc, SQLITE_OK);
 